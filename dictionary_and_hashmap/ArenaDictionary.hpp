@@ -0,0 +1,240 @@
+#ifndef _ARENA_DICTIONARY_HPP_
+#define _ARENA_DICTIONARY_HPP_
+
+#include "Dictionary.hpp"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#define ARENA_BLOCK_SIZE (1 << 16)
+
+// A handle to bytes stored in a StringArena.
+struct ArenaString
+{
+  uint32_t block, offset, length;
+};
+
+// Append-only storage for string bytes: strings are copied into large
+// blocks and never move, so a 12-byte handle locates them. Strings longer
+// than a block get a block of their own.
+class StringArena
+{
+ public:
+  ArenaString store(std::string_view text)
+  {
+    if (text.size() > ARENA_BLOCK_SIZE - _used || _blocks.empty())
+    {
+      size_t size = std::max(text.size(), (size_t) ARENA_BLOCK_SIZE);
+      _blocks.emplace_back(new char[size]);
+      _used = 0;
+      _reserved += size;
+    }
+    ArenaString handle{(uint32_t) _blocks.size() - 1, (uint32_t) _used,
+                       (uint32_t) text.size()};
+    std::memcpy(_blocks.back().get() + _used, text.data(), text.size());
+    // An oversized block is full; the next string opens a new one.
+    _used = text.size() > ARENA_BLOCK_SIZE ? ARENA_BLOCK_SIZE
+                                           : _used + text.size();
+    _stored += text.size();
+    return handle;
+  }
+
+  std::string_view view(const ArenaString &handle) const
+  {
+    return std::string_view(_blocks[handle.block].get() + handle.offset,
+                            handle.length);
+  }
+
+  // Bytes of the strings stored so far, and bytes allocated for the blocks.
+  size_t stored_bytes() const
+  { return _stored;}
+
+  size_t reserved_bytes() const
+  { return _reserved;}
+
+ private:
+  std::vector<std::unique_ptr<char[]>> _blocks;
+  size_t _used = 0, _stored = 0, _reserved = 0;
+};
+
+// Hashes and compares handles by the bytes they point to, so they can also
+// be looked up with a std::string_view.
+struct ArenaHash
+{
+  using is_transparent = void;
+  const StringArena *arena;
+
+  size_t operator()(std::string_view text) const
+  { return HashMapHash<std::string>{}(text); }
+
+  size_t operator()(const ArenaString &handle) const
+  { return operator()(arena->view(handle)); }
+};
+
+struct ArenaKeyEqual
+{
+  using is_transparent = void;
+  const StringArena *arena;
+
+  std::string_view view(const ArenaString &handle) const
+  { return arena->view(handle); }
+
+  std::string_view view(std::string_view text) const
+  { return text; }
+
+  template <typename A, typename B>
+  bool operator()(const A &a, const B &b) const
+  { return view(a) == view(b); }
+};
+
+// Hashing a handle dereferences the arena, so keep the hash in the entry.
+template <>
+struct cache_hash_code<ArenaString> : std::true_type {};
+
+// A Dictionary whose keys and values live in a StringArena: an entry of the
+// table is two handles instead of two heap-allocated std::strings. With
+// value interning, equal values share their bytes. The arena only grows:
+// bytes of erased or replaced strings are not reused.
+class ArenaDictionary
+{
+ public:
+  typedef HashMap<ArenaString, ArenaString, ArenaHash, ArenaKeyEqual> MapT;
+  // An interned value: the handle shared by its entries and their number.
+  struct Interned
+  {
+    ArenaString handle;
+    int references;
+  };
+  typedef HashMap<ArenaString, Interned, ArenaHash, ArenaKeyEqual> InternedT;
+
+  explicit ArenaDictionary(bool intern_values = false)
+      : _arena(new StringArena()),
+        _map(ArenaHash{_arena.get()}, ArenaKeyEqual{_arena.get()}),
+        _values(ArenaHash{_arena.get()}, ArenaKeyEqual{_arena.get()}),
+        _intern_values(intern_values) {}
+
+  // The tables hold pointers to the arena.
+  ArenaDictionary(const ArenaDictionary &other) = delete;
+
+  ArenaDictionary& operator=(const ArenaDictionary &other) = delete;
+
+  bool insert(std::string_view key, std::string_view value)
+  { return find_or_insert(key, value).second; }
+
+  // Returns true if the key was inserted, false if its value was assigned.
+  bool insert_or_assign(std::string_view key, std::string_view value)
+  {
+    std::pair<ArenaString *, bool> found = find_or_insert(key, value);
+    // Assigning the value the key already has stores nothing.
+    if (found.second || _arena->view(*found.first) == value)
+    {
+      return found.second;
+    }
+    ArenaString new_value = store_value(value);
+    release_value(*found.first);
+    *found.first = new_value;
+    return false;
+  }
+
+  template<class ForwardIterator>
+  void update(ForwardIterator start, ForwardIterator end)
+  {
+    for (auto it = start ; it != end ; it++)
+    {
+      insert_or_assign(it->first, it->second);
+    }
+  }
+
+  // Throws InvalidKey if the key is missing, like Dictionary::erase.
+  bool erase(std::string_view key)
+  {
+    ArenaString value{};
+    if (!_map.take(key, value))
+    {
+      throw InvalidKey();
+    }
+    release_value(value);
+    return true;
+  }
+
+  bool contains_key(std::string_view key) const
+  { return _map.contains_key(key); }
+
+  // The view stays valid until the entry is erased or assigned.
+  std::string_view at(std::string_view key) const
+  { return _arena->view(_map.at(key)); }
+
+  int size() const
+  { return _map.size();}
+
+  bool empty() const
+  { return _map.empty();}
+
+  const StringArena& arena() const
+  { return *_arena;}
+
+  // Number of distinct values kept when interning.
+  int interned_values() const
+  { return _values.size();}
+
+ private:
+  std::unique_ptr<StringArena> _arena;
+  MapT _map;
+  InternedT _values;
+  bool _intern_values;
+
+  // Converts to the handle of the text stored in the arena, so that the
+  // map stores the key and value only if it inserts them.
+  struct StoredKey
+  {
+    StringArena *arena;
+    std::string_view text;
+
+    operator ArenaString() const
+    { return arena->store(text); }
+  };
+
+  struct StoredValue
+  {
+    ArenaDictionary *dictionary;
+    std::string_view text;
+
+    operator ArenaString() const
+    { return dictionary->store_value(text); }
+  };
+
+  // The key's value handle, inserting the key with value if it is missing;
+  // a single lookup either way.
+  std::pair<ArenaString *, bool> find_or_insert(std::string_view key,
+                                                std::string_view value)
+  {
+    return _map.find_or_insert(key, StoredKey{_arena.get(), key},
+                               StoredValue{this, value});
+  }
+
+  ArenaString store_value(std::string_view value)
+  {
+    if (!_intern_values)
+    {
+      return _arena->store(value);
+    }
+    Interned *interned = _values.find(value);
+    if (interned != nullptr)
+    {
+      interned->references++;
+      return interned->handle;
+    }
+    ArenaString handle = _arena->store(value);
+    _values.insert(handle, Interned{handle, 1});
+    return handle;
+  }
+
+  void release_value(const ArenaString &value)
+  {
+    if (_intern_values && --_values.find(value)->references == 0)
+    {
+      _values.erase(value);
+    }
+  }
+};
+
+#endif //_ARENA_DICTIONARY_HPP_
@@ -0,0 +1,169 @@
+#ifndef _CONCURRENT_HASHMAP_HPP_
+#define _CONCURRENT_HASHMAP_HPP_
+
+#include "HashMap.hpp"
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#define DEFAULT_SHARD_COUNT 16
+#define CACHE_LINE_SIZE 64
+#define INVALID_SHARD_COUNT_ERROR "Error: Shard count must be positive!"
+
+// A thread-safe HashMap: keys are partitioned into a power-of-two number of
+// shards, each an independent HashMap behind its own reader-writer lock, so
+// threads working on different shards never contend. Lookups return copies,
+// since a reference into a shard can't outlive its lock.
+template <typename KeyT, typename ValueT>
+class ConcurrentHashMap
+{
+ public:
+  typedef HashMap<KeyT, ValueT> MapT;
+  typedef typename MapT::HashT HashT;
+
+  explicit ConcurrentHashMap(int shard_count = DEFAULT_SHARD_COUNT);
+
+  ConcurrentHashMap(const ConcurrentHashMap &other) = delete;
+
+  ConcurrentHashMap& operator=(const ConcurrentHashMap &other) = delete;
+
+  bool insert(const KeyT &key, const ValueT &value)
+  {
+    Shard &shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.map.insert(key, value);
+  }
+
+  // Returns true if the key was inserted, false if its value was assigned.
+  bool insert_or_assign(const KeyT &key, const ValueT &value)
+  {
+    Shard &shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.map.insert_or_assign(key, value);
+  }
+
+  // Inserts or assigns every pair of the range, one shard lock at a time.
+  template <class ForwardIterator>
+  void update(ForwardIterator start, ForwardIterator end)
+  {
+    for (auto it = start ; it != end ; it++)
+    {
+      insert_or_assign(it->first, it->second);
+    }
+  }
+
+  template <typename K = KeyT>
+  bool erase(const K &key)
+  {
+    Shard &shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.map.erase(key);
+  }
+
+  template <typename K = KeyT>
+  bool contains_key(const K &key) const
+  {
+    const Shard &shard = shard_of(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.map.contains_key(key);
+  }
+
+  template <typename K = KeyT>
+  ValueT at(const K &key) const
+  {
+    const Shard &shard = shard_of(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.map.at(key);
+  }
+
+  // Copies the value into out if the key is present; doesn't throw.
+  template <typename K = KeyT>
+  bool find(const K &key, ValueT &out) const
+  {
+    const Shard &shard = shard_of(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    const ValueT *value = shard.map.find(key);
+    if (value == nullptr)
+    {
+      return false;
+    }
+    out = *value;
+    return true;
+  }
+
+  // The shards are locked one after the other, so under concurrent writes
+  // the result is not a snapshot of a single moment.
+  int size() const;
+
+  bool empty() const
+  { return size() == 0;}
+
+  void clear();
+
+  int shard_count() const
+  { return _shard_count;}
+
+ private:
+  struct alignas(CACHE_LINE_SIZE) Shard
+  {
+    mutable std::shared_mutex mutex;
+    MapT map;
+  };
+
+  std::unique_ptr<Shard[]> _shards;
+  int _shard_count, _shard_bits;
+
+  // The shard comes from the top bits of a Fibonacci-multiplied hash, which
+  // don't overlap the low bits the shard's own table uses for its buckets.
+  template <typename K>
+  Shard& shard_of(const K &key) const
+  {
+    if (_shard_bits == 0)
+    {
+      return _shards[0];
+    }
+    unsigned long long mixed = (unsigned long long) HashT{}(key) *
+                               0x9E3779B97F4A7C15ULL;
+    return _shards[mixed >> (64 - _shard_bits)];
+  }
+};
+
+template <typename KeyT, typename ValueT>
+ConcurrentHashMap<KeyT, ValueT>::ConcurrentHashMap(int shard_count)
+{
+  if (shard_count <= 0)
+  {
+    throw std::invalid_argument(INVALID_SHARD_COUNT_ERROR);
+  }
+  _shard_count = 1;
+  _shard_bits = 0;
+  while (_shard_count < shard_count)
+  {
+    _shard_count *= 2;
+    _shard_bits++;
+  }
+  _shards.reset(new Shard[_shard_count]);
+}
+
+template <typename KeyT, typename ValueT>
+int ConcurrentHashMap<KeyT, ValueT>::size() const
+{
+  int size = 0;
+  for (int i = 0 ; i < _shard_count ; i++)
+  {
+    std::shared_lock<std::shared_mutex> lock(_shards[i].mutex);
+    size += _shards[i].map.size();
+  }
+  return size;
+}
+
+template <typename KeyT, typename ValueT>
+void ConcurrentHashMap<KeyT, ValueT>::clear()
+{
+  for (int i = 0 ; i < _shard_count ; i++)
+  {
+    std::unique_lock<std::shared_mutex> lock(_shards[i].mutex);
+    _shards[i].map.clear();
+  }
+}
+
+#endif //_CONCURRENT_HASHMAP_HPP_
@@ -25,7 +25,12 @@ class Dictionary : public HashMap<std::string, std::string>
               const std::vector<std::string> &values) :
               HashMap<std::string, std::string>(keys, values) {}
 
+   // A missing key throws InvalidKey, except in the range form, which
+   // returns the number of keys erased rather than stop halfway through.
+   using HashMap<std::string, std::string>::erase;
    bool erase(const std::string &key) override;
+   template <typename K, EnableIfTransparent<K> = 0>
+   bool erase(const K &key);
    template<class ForwardIterator>
    void update(ForwardIterator start, ForwardIterator end);
 };
@@ -39,16 +44,23 @@ bool Dictionary::erase (const std::string &key)
    return true;
  }
 
+template <typename K, Dictionary::EnableIfTransparent<K>>
+bool Dictionary::erase (const K &key)
+ {
+    if (!HashMap<std::string, std::string>::erase(key))
+   {
+     throw InvalidKey();
+   }
+   return true;
+ }
+
 template<class ForwardIterator>
 void Dictionary::update(const ForwardIterator start, const
 ForwardIterator end)
 {
   for (auto it = start ; it != end ; it++)
     {
-      if (!HashMap<std::string, std::string>::insert(it->first, it->second))
-        {
-          HashMap<std::string, std::string>::at(it->first) = it->second;
-        }
+      insert_or_assign(it->first, it->second);
     }
 }
 
@@ -0,0 +1,297 @@
+#ifndef _DICTIONARY_SNAPSHOT_HPP_
+#define _DICTIONARY_SNAPSHOT_HPP_
+
+#include "Dictionary.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SNAPSHOT_MAGIC "DICTSNAP"
+#define SNAPSHOT_MAGIC_SIZE 8
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_WRITE_ERROR "Error: Can't write the dictionary snapshot!"
+#define SNAPSHOT_OPEN_ERROR "Error: Can't open the dictionary snapshot!"
+#define SNAPSHOT_FORMAT_ERROR "Error: Invalid dictionary snapshot!"
+
+// A read-only Dictionary image that is used straight from an mmap-ed file.
+// Layout (native byte order, all offsets relative to the start of the file,
+// so the image works at any address):
+//   SnapshotHeader
+//   uint32_t bucket_starts[bucket_count + 1]  entries of bucket b are
+//                                             [bucket_starts[b],
+//                                              bucket_starts[b + 1])
+//   SnapshotEntry entries[entry_count]        grouped by bucket
+//   char strings[]                            key and value bytes
+// The hash must not change between the run that writes a snapshot and the
+// runs that read it, so it is FNV-1a (mixed) and not std::hash.
+
+struct SnapshotHeader
+{
+  char magic[SNAPSHOT_MAGIC_SIZE];
+  uint32_t version;
+  uint32_t bucket_count; // a power of two.
+  uint64_t entry_count;
+  uint64_t buckets_offset, entries_offset, strings_offset, file_size;
+};
+
+struct SnapshotEntry
+{
+  uint64_t hash;
+  uint64_t key_offset, value_offset; // relative to the strings.
+  uint32_t key_length, value_length;
+};
+
+inline uint64_t snapshot_hash(std::string_view key)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (char c : key)
+  {
+    hash = (hash ^ (unsigned char) c) * 0x100000001b3ULL;
+  }
+  return mix_hash(hash);
+}
+
+// Writes the dictionary to path as a snapshot that MappedDictionary opens.
+inline void write_snapshot(const Dictionary &dict, const std::string &path)
+{
+  uint32_t bucket_count = 1;
+  while (bucket_count < (uint32_t) dict.size())
+  {
+    bucket_count *= 2;
+  }
+
+  // Counting sort of the entries by bucket.
+  std::vector<uint32_t> bucket_starts(bucket_count + 1, 0);
+  std::vector<std::pair<uint64_t, const std::pair<std::string, std::string> *>>
+      pairs;
+  pairs.reserve(dict.size());
+  for (const auto &pair : dict)
+  {
+    uint64_t hash = snapshot_hash(pair.first);
+    pairs.emplace_back(hash, &pair);
+    bucket_starts[(hash & (bucket_count - 1)) + 1]++;
+  }
+  for (uint32_t b = 0 ; b < bucket_count ; b++)
+  {
+    bucket_starts[b + 1] += bucket_starts[b];
+  }
+  std::vector<SnapshotEntry> entries(pairs.size());
+  std::vector<uint32_t> next(bucket_starts.begin(), bucket_starts.end() - 1);
+  std::string strings;
+  for (const auto &hashed : pairs)
+  {
+    const std::pair<std::string, std::string> &pair = *hashed.second;
+    SnapshotEntry &entry = entries[next[hashed.first & (bucket_count - 1)]++];
+    entry.hash = hashed.first;
+    entry.key_offset = strings.size();
+    entry.key_length = (uint32_t) pair.first.size();
+    strings += pair.first;
+    entry.value_offset = strings.size();
+    entry.value_length = (uint32_t) pair.second.size();
+    strings += pair.second;
+  }
+
+  SnapshotHeader header{};
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE);
+  header.version = SNAPSHOT_VERSION;
+  header.bucket_count = bucket_count;
+  header.entry_count = entries.size();
+  header.buckets_offset = sizeof(SnapshotHeader);
+  header.entries_offset = header.buckets_offset +
+                          sizeof(uint32_t) * bucket_starts.size();
+  header.entries_offset = (header.entries_offset + alignof(SnapshotEntry) - 1)
+                          / alignof(SnapshotEntry) * alignof(SnapshotEntry);
+  header.strings_offset = header.entries_offset +
+                          sizeof(SnapshotEntry) * entries.size();
+  header.file_size = header.strings_offset + strings.size();
+
+  std::string padding(header.entries_offset - header.buckets_offset -
+                      sizeof(uint32_t) * bucket_starts.size(), '\0');
+  const std::pair<const void *, size_t> parts[] = {
+      {&header, sizeof(header)},
+      {bucket_starts.data(), sizeof(uint32_t) * bucket_starts.size()},
+      {padding.data(), padding.size()},
+      {entries.data(), sizeof(SnapshotEntry) * entries.size()},
+      {strings.data(), strings.size()}};
+
+  // Written to a temporary file next to path and renamed over it once it's
+  // on disk, so a crash or an error never leaves a partial snapshot at path,
+  // and dictionaries still mapping the old snapshot keep seeing it whole.
+  std::string temp_path = path + ".XXXXXX";
+  int fd = mkstemp(&temp_path[0]);
+  if (fd < 0)
+  {
+    throw std::runtime_error(SNAPSHOT_WRITE_ERROR);
+  }
+  bool written = fchmod(fd, 0644) == 0;
+  for (const std::pair<const void *, size_t> &part : parts)
+  {
+    const char *data = (const char *) part.first;
+    size_t left = part.second;
+    while (written && left > 0)
+    {
+      ssize_t count = ::write(fd, data, left);
+      if (count < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      written = count > 0;
+      if (written)
+      {
+        data += count;
+        left -= count;
+      }
+    }
+  }
+  written = written && fsync(fd) == 0;
+  written = close(fd) == 0 && written;
+  if (!written || std::rename(temp_path.c_str(), path.c_str()) != 0)
+  {
+    unlink(temp_path.c_str());
+    throw std::runtime_error(SNAPSHOT_WRITE_ERROR);
+  }
+}
+
+// A read-only view of a snapshot written by write_snapshot. Opening only
+// maps the file and checks its header, so lookups can start immediately;
+// pages are read in by the OS as lookups touch them. A corrupt snapshot
+// makes the constructor or a lookup throw SNAPSHOT_FORMAT_ERROR.
+class MappedDictionary
+{
+ public:
+  explicit MappedDictionary(const std::string &path);
+
+  MappedDictionary(const MappedDictionary &other) = delete;
+
+  MappedDictionary& operator=(const MappedDictionary &other) = delete;
+
+  ~MappedDictionary()
+  { munmap(_data, _length); }
+
+  int size() const
+  { return (int) _header->entry_count;}
+
+  bool empty() const
+  { return size() == 0;}
+
+  bool contains_key(std::string_view key) const
+  { return find(key) != nullptr; }
+
+  // The returned view points into the mapping, so it's valid as long as
+  // the MappedDictionary is.
+  std::string_view at(std::string_view key) const
+  {
+    const SnapshotEntry *entry = find(key);
+    if (entry == nullptr)
+    {
+      throw std::out_of_range(KEY_ERROR);
+    }
+    return string_at(entry->value_offset, entry->value_length);
+  }
+
+ private:
+  void *_data;
+  size_t _length;
+  const SnapshotHeader *_header;
+  const uint32_t *_bucket_starts;
+  const SnapshotEntry *_entries;
+  const char *_strings;
+  size_t _strings_size;
+
+  // Bucket starts and entries are checked as lookups read them, since
+  // checking them all on open would mean reading the whole file.
+  const SnapshotEntry* find(std::string_view key) const
+  {
+    uint64_t hash = snapshot_hash(key);
+    uint32_t bucket = hash & (_header->bucket_count - 1);
+    uint32_t first = _bucket_starts[bucket], last = _bucket_starts[bucket + 1];
+    if (first > last || last > _header->entry_count)
+    {
+      throw std::runtime_error(SNAPSHOT_FORMAT_ERROR);
+    }
+    for (uint32_t i = first ; i < last ; i++)
+    {
+      const SnapshotEntry &entry = _entries[i];
+      if (entry.hash == hash && entry.key_length == key.size() &&
+          string_at(entry.key_offset, entry.key_length) == key)
+      {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  std::string_view string_at(uint64_t offset, uint32_t length) const
+  {
+    if (offset > _strings_size || length > _strings_size - offset)
+    {
+      throw std::runtime_error(SNAPSHOT_FORMAT_ERROR);
+    }
+    return std::string_view(_strings + offset, length);
+  }
+
+  // Checks that every offset of the header stays inside the file, in an
+  // order that only subtracts offsets already known to be ordered, so a
+  // corrupt header can't make a sum wrap around.
+  bool valid() const
+  {
+    const SnapshotHeader &h = *_header;
+    uint32_t bucket_count = h.bucket_count;
+    return std::memcmp(h.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE) == 0 &&
+           h.version == SNAPSHOT_VERSION && h.file_size == _length &&
+           bucket_count != 0 && (bucket_count & (bucket_count - 1)) == 0 &&
+           h.buckets_offset >= sizeof(SnapshotHeader) &&
+           h.buckets_offset % alignof(uint32_t) == 0 &&
+           h.buckets_offset <= h.entries_offset &&
+           (h.entries_offset - h.buckets_offset) / sizeof(uint32_t) >
+           bucket_count &&
+           h.entries_offset % alignof(SnapshotEntry) == 0 &&
+           h.entries_offset <= h.strings_offset && h.strings_offset <= _length &&
+           (h.strings_offset - h.entries_offset) % sizeof(SnapshotEntry) == 0 &&
+           (h.strings_offset - h.entries_offset) / sizeof(SnapshotEntry) ==
+           h.entry_count;
+  }
+};
+
+inline MappedDictionary::MappedDictionary(const std::string &path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error(SNAPSHOT_OPEN_ERROR);
+  }
+  struct stat info{};
+  if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(SnapshotHeader))
+  {
+    close(fd);
+    throw std::runtime_error(SNAPSHOT_FORMAT_ERROR);
+  }
+  _length = (size_t) info.st_size;
+  _data = mmap(nullptr, _length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (_data == MAP_FAILED)
+  {
+    throw std::runtime_error(SNAPSHOT_OPEN_ERROR);
+  }
+  const char *base = (const char *) _data;
+  _header = (const SnapshotHeader *) base;
+  if (!valid())
+  {
+    munmap(_data, _length);
+    throw std::runtime_error(SNAPSHOT_FORMAT_ERROR);
+  }
+  _bucket_starts = (const uint32_t *) (base + _header->buckets_offset);
+  _entries = (const SnapshotEntry *) (base + _header->entries_offset);
+  _strings = base + _header->strings_offset;
+  _strings_size = _length - _header->strings_offset;
+  if (_bucket_starts[_header->bucket_count] != _header->entry_count)
+  {
+    munmap(_data, _length);
+    throw std::runtime_error(SNAPSHOT_FORMAT_ERROR);
+  }
+}
+
+#endif //_DICTIONARY_SNAPSHOT_HPP_
@@ -0,0 +1,289 @@
+#ifndef _FROZEN_HASHMAP_HPP_
+#define _FROZEN_HASHMAP_HPP_
+
+#include <algorithm>
+#include "Dictionary.hpp"
+#define FROZEN_BUCKET_SIZE 3
+#define FROZEN_LOAD_FACTOR 0.99
+#define LARGE_PILOT 0xFF
+#define MAX_PILOT (1u << 24)
+#define FALLBACK_PILOT 0xFFFFFFFF
+
+// An immutable map built once from a HashMap, indexed by a minimal perfect
+// hash in the CHD / PTHash style: keys are split by hash into buckets of
+// about FROZEN_BUCKET_SIZE keys, and each bucket gets a pilot, found at build
+// time, that sends all of its keys to free slots of a table of
+// size / FROZEN_LOAD_FACTOR. The few slots past size are remapped to the
+// holes below it, so the pairs are stored densely and a lookup reads one
+// pilot and compares one key (after its cached hash, if the key type
+// caches one).
+// Pilots take a byte each; the few buckets that needed LARGE_PILOT tries or
+// more keep theirs in a sorted list, for about 3.5 bits of index per key.
+// Buckets no pilot can place (keys with identical hashes) go to a small
+// HashMap.
+template <typename KeyT, typename ValueT, typename Hash = HashMapHash<KeyT>,
+          typename KeyEqual = std::equal_to<>>
+class FrozenHashMap
+{
+ public:
+  typedef HashMap<KeyT, ValueT, Hash, KeyEqual> MapT;
+  typedef typename MapT::PairT PairT;
+  typedef typename MapT::Entry Entry;
+
+  // Iterates over the pairs placed by the perfect hash, then over the
+  // fallback's.
+  class const_iterator
+  {
+   public:
+    typedef typename std::vector<Entry>::const_iterator EntryIterator;
+    typedef typename MapT::const_iterator FallbackIterator;
+
+    const_iterator(EntryIterator it, EntryIterator entries_end,
+                   FallbackIterator fallback)
+        : _it(it), _entries_end(entries_end), _fallback(fallback) {}
+
+    const PairT& operator*() const
+    { return _it != _entries_end ? _it->pair : *_fallback; }
+
+    const PairT* operator->() const
+    { return &operator*(); }
+
+    const_iterator& operator++()
+    {
+      if (_it != _entries_end)
+      {
+        ++_it;
+      }
+      else
+      {
+        ++_fallback;
+      }
+      return *this;
+    }
+
+    bool operator==(const const_iterator &other) const
+    { return _it == other._it && _fallback == other._fallback; }
+
+    bool operator!=(const const_iterator &other) const
+    { return !operator==(other); }
+
+   private:
+    EntryIterator _it, _entries_end;
+    mutable FallbackIterator _fallback; // its operator* isn't const.
+  };
+
+  explicit FrozenHashMap(const MapT &map);
+
+  template <typename K = KeyT>
+  bool contains_key(const K &key) const
+  { return find(key) != nullptr; }
+
+  template <typename K = KeyT>
+  const ValueT& at(const K &key) const
+  {
+    const ValueT *value = find(key);
+    if (value == nullptr)
+    {
+      throw std::out_of_range(KEY_ERROR);
+    }
+    return *value;
+  }
+
+  int size() const
+  { return (int) _entries.size() + _fallback.size();}
+
+  bool empty() const
+  { return size() == 0;}
+
+  const_iterator begin() const
+  {
+    return const_iterator(_entries.begin(), _entries.end(),
+                          _fallback.begin());
+  }
+
+  const_iterator end() const
+  { return const_iterator(_entries.end(), _entries.end(), _fallback.end()); }
+
+  // Bits of the index: the pilots, the large pilots and the remapped slots.
+  size_t index_bits() const
+  {
+    return 8 * _pilots.size() + 64 * _large_pilots.size() +
+           32 * _remap.size();
+  }
+
+ private:
+  typedef std::pair<uint32_t, uint32_t> LargePilot; // bucket, pilot.
+
+  Hash _hasher;
+  KeyEqual _key_equal;
+  std::vector<uint8_t> _pilots; // one per bucket.
+  std::vector<LargePilot> _large_pilots; // sorted by bucket.
+  std::vector<uint32_t> _remap; // slots from _entries.size() up to _slots.
+  size_t _slots;
+  std::vector<Entry> _entries; // by perfect hash index.
+  MapT _fallback;
+
+  // Maps a hash onto [0, size) without a division.
+  static size_t reduce(uint64_t hash, size_t size)
+  { return (size_t) (((unsigned __int128) hash * size) >> 64); }
+
+  size_t slot(uint64_t hash, uint32_t pilot) const
+  { return reduce(mix_hash(hash ^ (pilot * 0x9E3779B97F4A7C15ULL)), _slots); }
+
+  uint32_t pilot(size_t bucket) const
+  {
+    uint32_t pilot = _pilots[bucket];
+    if (pilot == LARGE_PILOT)
+    {
+      pilot = std::lower_bound(_large_pilots.begin(), _large_pilots.end(),
+                               LargePilot((uint32_t) bucket, 0))->second;
+    }
+    return pilot;
+  }
+
+  template <typename K>
+  const ValueT* find(const K &key) const
+  {
+    uint64_t hash = _hasher(key);
+    uint32_t pilot = this->pilot(reduce(hash, _pilots.size()));
+    if (pilot != FALLBACK_PILOT)
+    {
+      if (_entries.empty())
+      {
+        return nullptr; // no key was placed, e.g. the map was empty.
+      }
+      size_t index = slot(hash, pilot);
+      if (index >= _entries.size())
+      {
+        index = _remap[index - _entries.size()];
+      }
+      const Entry &entry = _entries[index];
+      return entry.may_match(hash) && _key_equal(entry.pair.first, key) ?
+             &entry.pair.second : nullptr;
+    }
+    return _fallback.find(key);
+  }
+};
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual>
+FrozenHashMap<KeyT, ValueT, Hash, KeyEqual>::FrozenHashMap(const MapT &map)
+: _hasher(map.hash_function()), _key_equal(map.key_eq()),
+  _fallback(_hasher, _key_equal)
+{
+  size_t n = map.size();
+  size_t buckets = std::max((size_t) 1, n / FROZEN_BUCKET_SIZE);
+  _slots = std::max((size_t) 1, (size_t) (n / FROZEN_LOAD_FACTOR));
+  _pilots.assign(buckets, 0);
+
+  // Sort the pairs by bucket, and the buckets from the largest down: the
+  // large ones are placed while the table is still mostly free.
+  std::vector<const PairT *> pairs;
+  std::vector<uint64_t> hashes;
+  std::vector<size_t> starts(buckets + 1, 0);
+  for (const PairT &pair : map)
+  {
+    pairs.push_back(&pair);
+    hashes.push_back(_hasher(pair.first));
+    starts[reduce(hashes.back(), buckets) + 1]++;
+  }
+  for (size_t b = 0 ; b < buckets ; b++)
+  {
+    starts[b + 1] += starts[b];
+  }
+  std::vector<size_t> by_bucket(n), next(starts.begin(), starts.end() - 1);
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    by_bucket[next[reduce(hashes[i], buckets)]++] = i;
+  }
+  std::vector<size_t> order(buckets);
+  for (size_t b = 0 ; b < buckets ; b++)
+  {
+    order[b] = b;
+  }
+  std::stable_sort(order.begin(), order.end(), [&starts](size_t a, size_t b)
+  { return starts[a + 1] - starts[a] > starts[b + 1] - starts[b]; });
+
+  std::vector<bool> taken(_slots, false);
+  std::vector<size_t> slot_of(n, _slots), placed;
+  size_t placed_count = 0;
+  for (size_t b : order)
+  {
+    bool found = false;
+    uint32_t pilot = 0;
+    for ( ; pilot < MAX_PILOT && !found ; pilot++)
+    {
+      placed.clear();
+      found = true;
+      for (size_t k = starts[b] ; k < starts[b + 1] && found ; k++)
+      {
+        size_t s = slot(hashes[by_bucket[k]], pilot);
+        found = !taken[s];
+        taken[s] = true;
+        placed.push_back(s);
+      }
+      for (size_t s = 0 ; !found && s + 1 < placed.size() ; s++)
+      {
+        taken[placed[s]] = false;
+      }
+    }
+    pilot = found ? pilot - 1 : FALLBACK_PILOT;
+    _pilots[b] = (uint8_t) std::min(pilot, (uint32_t) LARGE_PILOT);
+    if (pilot >= LARGE_PILOT)
+    {
+      _large_pilots.push_back(LargePilot((uint32_t) b, pilot));
+    }
+    for (size_t k = starts[b] ; k < starts[b + 1] ; k++)
+    {
+      if (found)
+      {
+        slot_of[by_bucket[k]] = placed[k - starts[b]];
+      }
+      else
+      {
+        _fallback.insert(*pairs[by_bucket[k]]);
+      }
+    }
+    placed_count += found ? starts[b + 1] - starts[b] : 0;
+  }
+  std::sort(_large_pilots.begin(), _large_pilots.end());
+
+  // Slots at or past placed_count take the holes below it, in order.
+  _remap.assign(_slots - std::min(_slots, placed_count), 0);
+  size_t hole = 0;
+  for (size_t s = placed_count ; s < _slots ; s++)
+  {
+    if (taken[s])
+    {
+      while (taken[hole])
+      {
+        hole++;
+      }
+      _remap[s - placed_count] = (uint32_t) hole++;
+    }
+  }
+  std::vector<size_t> slots(placed_count);
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    size_t s = slot_of[i];
+    if (s != _slots)
+    {
+      slots[s < placed_count ? s : _remap[s - placed_count]] = i;
+    }
+  }
+  _entries.reserve(placed_count);
+  for (size_t i : slots)
+  {
+    _entries.emplace_back(hashes[i], *pairs[i]);
+  }
+}
+
+// A FrozenHashMap of a Dictionary, for key sets that are built once and then
+// only read.
+class FrozenDictionary : public FrozenHashMap<std::string, std::string>
+{
+ public:
+  explicit FrozenDictionary(const Dictionary &dict)
+      : FrozenHashMap<std::string, std::string>(dict) {}
+};
+
+#endif //_FROZEN_HASHMAP_HPP_
@@ -2,56 +2,403 @@
 #define _HASHMAP_HPP_
 
 #include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <type_traits>
+#include <tuple>
+#include <utility>
+#include <new>
+#include <memory>
+#include <memory_resource>
+#include <atomic>
 #include <stdexcept>
+#include <chrono>
+#include <sstream>
 #define INITIAL_CAPACITY 16
 #define MINIMAL_CAPACITY 1
 #define LOWER_LOAD_FACTOR 0.25
 #define UPPER_LOAD_FACTOR 0.75
 #define GROWTH_FACTOR 2
+#define MIGRATION_STEP 8
+#define BITMAP_WORD_BITS 64
+#define TABLE_CHUNK_BITS 14 // tables are allocated 16384 buckets at a time.
+#define TABLE_CHUNK (1 << TABLE_CHUNK_BITS)
+#define PREFETCH_DISTANCE 16
+#define SMALL_MAP_CAPACITY 8
 #define INVALID_KEYS_VALUES_ERROR "Error: Keys and Values don't match in size!"
 #define KEY_ERROR "Error: Key not in hash map!"
+#define INVALID_LOAD_FACTORS_ERROR "Error: Invalid load factors!"
 
-template <typename KeyT, typename ValueT>
+// The finalizer of MurmurHash3: every input bit affects every output bit.
+// The bucket is picked by the low bits of the hash, and std::hash is the
+// identity for integers, so without it keys that differ only in their high
+// bits (or are multiples of a power of two) share one bucket.
+constexpr size_t mix_hash(uint64_t hash)
+{
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return (size_t) hash;
+}
+
+// Default hasher of the HashMap: std::hash followed by mix_hash. Strings are
+// hashed as std::string_view (which std::hash treats like std::string), so
+// a const char* or a std::string_view can be looked up without building a
+// temporary std::string.
+template <typename KeyT>
+struct HashMapHash
+{
+  size_t operator()(const KeyT &key) const
+  { return mix_hash(std::hash<KeyT>{}(key)); }
+};
+
+template <>
+struct HashMapHash<std::string>
+{
+  using is_transparent = void;
+
+  size_t operator()(std::string_view key) const
+  { return mix_hash(std::hash<std::string_view>{}(key)); }
+};
+
+template <typename HashT, typename = void>
+struct is_transparent_hash : std::false_type {};
+
+template <typename HashT>
+struct is_transparent_hash<HashT, std::void_t<typename HashT::is_transparent>>
+    : std::true_type {};
+
+// Whether entries store the full hash of their key. A cached hash makes
+// rehashing free of hash calls and rejects most mismatches in a bucket
+// without comparing keys, at the cost of a size_t per entry. It's on for
+// std::string; specialize it for other key types that are costly to hash
+// or compare.
+template <typename KeyT>
+struct cache_hash_code : std::false_type {};
+
+template <>
+struct cache_hash_code<std::string> : std::true_type {};
+
+// A report of HashMap::stats(). Bucket sizes are the chain lengths: a hit
+// compares at most the keys of one chain, so a long tail in the histogram
+// (or a max_chain far above the load factor) means the keys hash poorly.
+struct HashMapStats
+{
+  int size, capacity;
+  double load_factor;
+  long hits, misses; // lookups since the stats were enabled or reset.
+  long rehashes;
+  double rehash_ms; // includes incremental migration steps.
+  size_t heap_bytes; // tables, chains and bitmaps, not what keys own.
+                     // Inline entries are part of the object, not counted.
+  int max_chain;
+  std::vector<int> chain_histogram; // [length] = buckets of that length.
+
+  std::string to_json() const
+  {
+    std::ostringstream out;
+    out << "{\"size\": " << size << ", \"capacity\": " << capacity
+        << ", \"load_factor\": " << load_factor << ", \"hits\": " << hits
+        << ", \"misses\": " << misses << ", \"rehashes\": " << rehashes
+        << ", \"rehash_ms\": " << rehash_ms << ", \"heap_bytes\": "
+        << heap_bytes << ", \"max_chain\": " << max_chain
+        << ", \"chain_histogram\": [";
+    for (size_t i = 0 ; i < chain_histogram.size() ; i++)
+    {
+      out << (i == 0 ? "" : ", ") << chain_histogram[i];
+    }
+    out << "]}";
+    return out.str();
+  }
+};
+
+template <typename PairT, bool CacheHash>
+struct HashMapEntry
+{
+  PairT pair;
+
+  template <typename... Args>
+  explicit HashMapEntry(size_t, Args &&... args)
+      : pair(std::forward<Args>(args)...) {}
+
+  bool may_match(size_t) const
+  { return true; }
+
+  template <typename HashT>
+  size_t hash_code(const HashT &hasher) const
+  { return hasher(pair.first); }
+};
+
+template <typename PairT>
+struct HashMapEntry<PairT, true>
+{
+  PairT pair;
+  size_t hash;
+
+  template <typename... Args>
+  explicit HashMapEntry(size_t key_hash, Args &&... args)
+      : pair(std::forward<Args>(args)...), hash(key_hash) {}
+
+  bool may_match(size_t key_hash) const
+  { return hash == key_hash; }
+
+  template <typename HashT>
+  size_t hash_code(const HashT &) const
+  { return hash; }
+};
+
+// Raw storage for the entries of a HashMap that still fits inline.
+template <typename EntryT, int N>
+struct InlineEntries
+{
+  alignas(EntryT) unsigned char bytes[N * sizeof(EntryT)];
+
+  EntryT* data()
+  { return std::launder(reinterpret_cast<EntryT *>(bytes)); }
+};
+
+template <typename EntryT>
+struct InlineEntries<EntryT, 0>
+{
+  EntryT* data()
+  { return nullptr; }
+};
+
+// Hash and KeyEqual may be stateful: the map keeps the instances it was
+// constructed with. Lookups by other key types need both to define
+// is_transparent.
+// The first InlineCapacity entries are kept in the object itself and
+// searched linearly without hashing; the bucket table is only allocated when
+// one more is inserted (so with the default of 0, on the first insert), and
+// freed again by clear(). Until then capacity() is the capacity the table
+// will start with.
+// The bucket array, the buckets' entries and the bitmaps are allocated with
+// (a rebound copy of) Allocator; keys and values allocate as their own types
+// do.
+// A copy shares the tables of the map it copies (only the bitmaps are copied,
+// O(capacity / 64)) until either of them changes (inserts a missing key,
+// assigns, erases a present key or rehashes) or returns a non-const
+// reference to a value (non-const at() or operator[] of a found key), which
+// first gives it its own copy of the tables. A map that returned such a
+// reference is copied eagerly until it is cleared, spills or fully rehashes,
+// as the reference could write to shared entries. Copies of one map may be
+// used by different threads.
+template <typename KeyT, typename ValueT, typename Hash = HashMapHash<KeyT>,
+          typename KeyEqual = std::equal_to<>, int InlineCapacity = 0,
+          typename Allocator = std::allocator<std::pair<KeyT, ValueT>>>
 class HashMap
 {
+  template <typename T>
+  using Rebind = typename std::allocator_traits<Allocator>::
+      template rebind_alloc<T>;
+
  public:
   typedef std::pair<KeyT, ValueT> PairT;
-  typedef std::vector<PairT> Buckets;
+  typedef HashMapEntry<PairT, cache_hash_code<KeyT>::value> Entry;
+  typedef std::vector<Entry, Rebind<Entry>> Buckets;
   typedef typename Buckets::iterator IterT;
+  typedef std::vector<uint64_t, Rebind<uint64_t>> Bitmap;
+  typedef Hash HashT;
+  typedef KeyEqual KeyEqualT;
+  typedef Allocator allocator_type;
+
+  // Lookups by a key of another type K (e.g. const char* or std::string_view
+  // for std::string keys) are enabled only for a transparent hasher.
+  template <typename K>
+  using EnableIfTransparent = std::enable_if_t<
+      is_transparent_hash<HashT>::value &&
+      is_transparent_hash<KeyEqualT>::value &&
+      !std::is_same<std::decay_t<K>, KeyT>::value, int>;
 
   HashMap();
 
-  HashMap(const std::vector<KeyT> &keys, const std::vector<ValueT> &values);
+  explicit HashMap(const Allocator &allocator);
+
+  explicit HashMap(const Hash &hasher, const KeyEqual &key_equal = KeyEqual(),
+                   const Allocator &allocator = Allocator());
 
-  HashMap(const HashMap<KeyT, ValueT>  &other);
+  HashMap(const std::vector<KeyT> &keys, const std::vector<ValueT> &values,
+          const Allocator &allocator = Allocator());
+
+  HashMap(const HashMap &other);
 
   virtual ~HashMap();
 
-  HashMap<KeyT, ValueT>& operator=(const HashMap<KeyT, ValueT> &other);
+  HashMap& operator=(const HashMap &other);
 
   class ConstIterator;
   friend class ConstIterator;
 
-  bool insert(const KeyT &key, const ValueT &value);
+  bool insert(const KeyT &key, const ValueT &value)
+  { return find_or_emplace (key, key, value).second; }
+
+  bool insert(KeyT &&key, ValueT &&value)
+  { return find_or_emplace (key, std::move (key), std::move (value)).second; }
+
+  bool insert(const PairT &pair)
+  { return find_or_emplace (pair.first, pair).second; }
 
-  virtual bool erase(const KeyT &key);
+  bool insert(PairT &&pair)
+  { return find_or_emplace (pair.first, std::move (pair)).second; }
+
+  // Builds the pair from args first, since its key is needed for the lookup.
+  template <typename... Args>
+  bool emplace(Args &&... args);
+
+  // Constructs the value from args only if the key is missing.
+  template <typename... Args>
+  bool try_emplace(const KeyT &key, Args &&... args);
+
+  template <typename... Args>
+  bool try_emplace(KeyT &&key, Args &&... args);
+
+  // Returns true if the key was inserted, false if its value was assigned.
+  template <typename M>
+  bool insert_or_assign(const KeyT &key, M &&value);
+
+  template <typename M>
+  bool insert_or_assign(KeyT &&key, M &&value);
+
+  virtual bool erase(const KeyT &key)
+  { return erase_key (key); }
+
+  template <typename K, EnableIfTransparent<K> = 0>
+  bool erase(const K &key)
+  { return erase_key (key); }
+
+  // Erases the key and moves its value to value: one lookup, where at() and
+  // then erase take two. Returns false, leaving value alone, if the key is
+  // missing.
+  bool take(const KeyT &key, ValueT &value)
+  { return erase_key (key, &value); }
+
+  template <typename K, EnableIfTransparent<K> = 0>
+  bool take(const K &key, ValueT &value)
+  { return erase_key (key, &value); }
+
+  // Erases the keys of [first, last) that are in the map and resizes at most
+  // once, after the last one. Returns the number of pairs erased.
+  template <typename InputIt>
+  int erase(InputIt first, InputIt last);
+
+  // Erases every pair pred(pair) is true for, in one pass over the buckets,
+  // and resizes at most once. Returns the number of pairs erased.
+  template <typename Pred>
+  int erase_if(Pred pred);
+
+  // Erases every pair pred(pair) is false for; see erase_if.
+  template <typename Pred>
+  int retain(Pred pred)
+  { return erase_if ([&pred](const PairT &pair) { return !pred (pair); }); }
 
   void clear();
 
   bool contains_key(const KeyT &key) const
-  { return get_iterator_position_on_bucket (key) != _null_iter; }
+  { return find_key (key) != nullptr; }
+
+  template <typename K, EnableIfTransparent<K> = 0>
+  bool contains_key(const K &key) const
+  { return find_key (key) != nullptr; }
+
+  // The key's value, or nullptr if it is missing: one lookup, where
+  // contains_key and then at() take two.
+  const ValueT* find(const KeyT &key) const
+  { return value_of (find_key (key)); }
+
+  template <typename K, EnableIfTransparent<K> = 0>
+  const ValueT* find(const K &key) const
+  { return value_of (find_key (key)); }
+
+  ValueT* find(const KeyT &key)
+  { return value_ptr (key); }
+
+  template <typename K, EnableIfTransparent<K> = 0>
+  ValueT* find(const K &key)
+  { return value_ptr (key); }
+
+  // Looks the key up once and, if it is missing, inserts the pair built from
+  // pair_args, which are used only then, so they may convert to the key and
+  // value lazily. Returns the key's value and whether it was inserted.
+  template <typename... Args>
+  std::pair<ValueT *, bool> find_or_insert(const KeyT &key,
+                                           Args &&... pair_args)
+  {
+    return owned_value (key, find_or_emplace (
+        key, std::forward<Args> (pair_args)...));
+  }
 
-  const ValueT & at(const KeyT &key) const;
+  template <typename K, typename... Args, EnableIfTransparent<K> = 0>
+  std::pair<ValueT *, bool> find_or_insert(const K &key, Args &&... pair_args)
+  {
+    return owned_value (key, find_or_emplace (
+        key, std::forward<Args> (pair_args)...));
+  }
+
+  const ValueT & at(const KeyT &key) const
+  { return value_at (key); }
+
+  template <typename K, EnableIfTransparent<K> = 0>
+  const ValueT & at(const K &key) const
+  { return value_at (key); }
+
+  ValueT & at(const KeyT &key)
+  { return value_at (key); }
+
+  template <typename K, EnableIfTransparent<K> = 0>
+  ValueT & at(const K &key)
+  { return value_at (key); }
+
+  // Looks up the keys of [first, last) and writes to out a pointer to each
+  // one's value, or nullptr for a missing key. The lookups are pipelined: a
+  // key is hashed and its bucket prefetched PREFETCH_DISTANCE keys ahead,
+  // and the bucket's entries half as far ahead, so that the cache misses of
+  // consecutive keys overlap instead of following each other.
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) const
+  {
+    resolve_many(first, last, [&out](const Entry *entry)
+    { *out++ = entry == nullptr ? nullptr : &entry->pair.second; });
+    return out;
+  }
+
+  // Like find_many, but writes the values; throws as at() does on a missing
+  // key, after the values of the keys before it were written.
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt at_many(ForwardIt first, ForwardIt last, OutputIt out) const
+  {
+    resolve_many(first, last, [&out](const Entry *entry)
+    {
+      if (entry == nullptr)
+      {
+        throw std::out_of_range(KEY_ERROR);
+      }
+      *out++ = entry->pair.second;
+    });
+    return out;
+  }
 
-  ValueT & at(const KeyT &key);
+  const ValueT operator[](const KeyT &key) const
+  { return value_or_default (key); }
 
-  const ValueT operator[](const KeyT &key) const;
+  template <typename K, EnableIfTransparent<K> = 0>
+  const ValueT operator[](const K &key) const
+  { return value_or_default (key); }
 
-  ValueT& operator[](const KeyT &key);
+  ValueT& operator[](const KeyT &key)
+  { return value_or_insert (key); }
 
-  bool operator==(const HashMap<KeyT, ValueT>& other) const;
+  template <typename K, EnableIfTransparent<K> = 0>
+  ValueT& operator[](const K &key)
+  { return value_or_insert (key); }
 
-  bool operator!=(const HashMap<KeyT, ValueT>& other) const
+  bool operator==(const HashMap& other) const;
+
+  bool operator!=(const HashMap& other) const
   { return !operator==(other);}
 
   int size() const
@@ -63,51 +410,704 @@ class HashMap
   bool empty() const
   { return _size == 0;}
 
-  int bucket_index(const KeyT &key) const;
+  int bucket_index(const KeyT &key) const
+  { return key_bucket_index (key); }
+
+  template <typename K, EnableIfTransparent<K> = 0>
+  int bucket_index(const K &key) const
+  { return key_bucket_index (key); }
 
   int bucket_size(const KeyT &key) const
-  { return _table[bucket_index(key)].size();}
+  { return key_bucket_size (key);}
+
+  template <typename K, EnableIfTransparent<K> = 0>
+  int bucket_size(const K &key) const
+  { return key_bucket_size (key);}
 
   double get_load_factor() const
   { return (double) _size / (double) _capacity;}
 
+  const Hash& hash_function() const
+  { return _hasher;}
+
+  const KeyEqual& key_eq() const
+  { return _key_equal;}
+
+  Allocator get_allocator() const
+  { return _allocator;}
+
+  double lower_load_factor() const
+  { return _lower_load_factor;}
+
+  double upper_load_factor() const
+  { return _upper_load_factor;}
+
+  // The lower bound must stay below upper / GROWTH_FACTOR, so that a table
+  // that just shrank (or grew) is not already out of bounds the other way.
+  void set_load_factors(double lower, double upper);
+
+  // Grows the table so n entries fit without rehashing; the table also won't
+  // shrink below that capacity until reserve is called again.
+  void reserve(int n);
+
+  // In incremental mode a resize only allocates the new table; every later
+  // insert or erase then moves MIGRATION_STEP buckets of the old table, so
+  // no single operation pays for moving the whole map.
+  void set_incremental_rehash(bool incremental);
+
+  bool incremental_rehash() const
+  { return _incremental_rehash;}
+
+  bool migrating() const
+  { return _old_table != nullptr;}
+
+  // Stats count lookups and time rehashes only while enabled; that costs a
+  // predictable branch per lookup and two clock reads per resize or
+  // migration step. Counting makes const lookups write to the map, so don't
+  // enable them on a map read by several threads at once.
+  void set_stats_enabled(bool enabled)
+  { _stats_enabled = enabled;}
+
+  bool stats_enabled() const
+  { return _stats_enabled;}
+
+  void reset_stats()
+  {
+    _hits = _misses = _rehashes = 0;
+    _rehash_ms = 0;
+  }
+
+  // The chain histogram and heap bytes walk every bucket: O(capacity).
+  HashMapStats stats() const;
+
  protected:
-  Buckets *_table;
+  Hash _hasher;
+  KeyEqual _key_equal;
+  Allocator _allocator;
+  // A table is an array of chunks of TABLE_CHUNK buckets (fewer for a
+  // smaller table), each allocated when one of its buckets is first used, so
+  // that a resize doesn't construct (or free) every bucket at once.
+  Buckets **_table = nullptr; // allocated once the inline entries are full.
   int _size, _capacity;
-  Buckets * _empty_table = new Buckets();
-  IterT _null_iter = _empty_table->end();
-  // IterT can't be compared to regular null_ptr according to CLion
+  int _min_capacity = MINIMAL_CAPACITY;
+  double _lower_load_factor = LOWER_LOAD_FACTOR;
+  double _upper_load_factor = UPPER_LOAD_FACTOR;
+  bool _incremental_rehash = false;
+  Buckets **_old_table = nullptr; // table being migrated from, if any.
+  int _old_capacity = 0, _migrated = 0; // buckets [0, _migrated) are moved.
+  // A set bit for every non-empty bucket.
+  Bitmap _occupied = Bitmap(_allocator), _old_occupied = Bitmap(_allocator);
+  mutable InlineEntries<Entry, InlineCapacity> _inline; // while no _table.
+  // Counts the maps sharing _table and _old_table; allocated with _table.
+  std::atomic<int> *_references = nullptr;
+  bool _unshareable = false; // a non-const reference to a value was returned.
+  bool _stats_enabled = false, _timing_rehash = false;
+  mutable long _hits = 0, _misses = 0;
+  long _rehashes = 0;
+  double _rehash_ms = 0;
+
+  void count_lookup(bool hit) const
+  {
+    if (_stats_enabled)
+    {
+      (hit ? _hits : _misses)++;
+    }
+  }
 
-  int hash(const KeyT& key, int new_cap) const
-  { return std::hash<KeyT>{}(key) & (new_cap - 1);}
+  // Adds the time it lives to the rehash time when stats are enabled. Nested
+  // timers (a rehash finishing a migration) count once.
+  class RehashTimer
+  {
+   public:
+    explicit RehashTimer(HashMap &map)
+        : _map(map), _active(map._stats_enabled && !map._timing_rehash)
+    {
+      if (_active)
+      {
+        _map._timing_rehash = true;
+        _start = std::chrono::steady_clock::now();
+      }
+    }
 
-  int hash(const KeyT &key) const
+    ~RehashTimer()
+    {
+      if (_active)
+      {
+        _map._rehash_ms += std::chrono::duration<double, std::milli>
+            (std::chrono::steady_clock::now() - _start).count();
+        _map._timing_rehash = false;
+      }
+    }
+
+   private:
+    HashMap &_map;
+    bool _active;
+    std::chrono::steady_clock::time_point _start;
+  };
+
+  template <typename K>
+  int hash(const K& key, int new_cap) const
+  { return _hasher(key) & (new_cap - 1);}
+
+  template <typename K>
+  int hash(const K &key) const
   {  return hash(key, _capacity); }
 
-  IterT get_iterator_position_on_bucket(KeyT key) const // O(bucket size) time
+  // Buckets are numbered through both tables: the current table first, then
+  // the old one while a migration is in progress. The inline entries count
+  // as the single bucket 0.
+  int bucket_count() const
+  { return _table == nullptr ? 1 : _capacity + _old_capacity;}
+
+  int entries_in(int bucket) const
+  { return _table == nullptr ? _size : (int) bucket_at(bucket).size();}
+
+  Entry& entry_at(int bucket, int i) const
+  { return _table == nullptr ? _inline.data()[i] : bucket_at(bucket)[i];}
+
+  // Only valid for a bucket of an allocated chunk, e.g. an occupied one.
+  Buckets& bucket_at(int i) const
+  {
+    return i < _capacity ? bucket_in(_table, i) :
+           bucket_in(_old_table, i - _capacity);
+  }
+
+  static Buckets& bucket_in(Buckets **table, int i)
+  { return table[i >> TABLE_CHUNK_BITS][i & (TABLE_CHUNK - 1)];}
+
+  static int chunk_size(int capacity)
+  { return std::min(capacity, TABLE_CHUNK);}
+
+  static int chunk_count(int capacity)
+  { return (capacity + TABLE_CHUNK - 1) / TABLE_CHUNK;}
+
+  bool occupied(int i) const
+  {
+    const Bitmap &bitmap = i < _capacity ? _occupied : _old_occupied;
+    int bit = i < _capacity ? i : i - _capacity;
+    return (bitmap[bit / BITMAP_WORD_BITS] >> (bit % BITMAP_WORD_BITS)) & 1;
+  }
+
+  // The bucket, to insert into: allocates its chunk if needed.
+  Buckets& occupy(int i)
+  {
+    Buckets &bucket = i < _capacity ? chunk_bucket(_table, _capacity, i) :
+        chunk_bucket(_old_table, _old_capacity, i - _capacity);
+    set_occupied(i, true);
+    return bucket;
+  }
+
+  // During a migration, keys whose old bucket wasn't moved yet (including
+  // keys inserted since) live in the old table, so every key has one bucket.
+  int bucket_position(size_t key_hash) const
+  {
+    if (_old_table != nullptr)
+    {
+      int old_index = key_hash & (_old_capacity - 1);
+      if (old_index >= _migrated)
+      {
+        return _capacity + old_index;
+      }
+    }
+    return key_hash & (_capacity - 1);
+  }
+
+  // Bucket i, or nullptr if its chunk isn't allocated (so it is empty).
+  Buckets* allocated_bucket(int i) const
+  {
+    Buckets **table = i < _capacity ? _table : _old_table;
+    int index = i < _capacity ? i : i - _capacity;
+    Buckets *chunk = table[index >> TABLE_CHUNK_BITS];
+    return chunk == nullptr ? nullptr : chunk + (index & (TABLE_CHUNK - 1));
+  }
+
+  Buckets* bucket_of(size_t key_hash) const
+  { return allocated_bucket(bucket_position(key_hash));}
+
+  void allocate_table(int capacity)
+  {
+    _capacity = capacity;
+    _table = new_table(capacity);
+    if (_references == nullptr)
+    {
+      _references = new_references();
+    }
+    _occupied.assign((capacity + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS, 0);
+  }
+
+  // A table of capacity buckets, with no chunk allocated yet.
+  Buckets** new_table(int capacity)
+  {
+    Rebind<Buckets *> chunks_allocator(_allocator);
+    Buckets **table = std::allocator_traits<Rebind<Buckets *>>::allocate
+        (chunks_allocator, chunk_count(capacity));
+    std::fill(table, table + chunk_count(capacity), nullptr);
+    return table;
+  }
+
+  // Bucket i of table, allocating (and constructing) its chunk if needed.
+  Buckets& chunk_bucket(Buckets **table, int capacity, int i)
+  {
+    Buckets *&chunk = table[i >> TABLE_CHUNK_BITS];
+    if (chunk == nullptr)
+    {
+      Rebind<Buckets> chunk_allocator(_allocator);
+      chunk = std::allocator_traits<Rebind<Buckets>>::allocate
+          (chunk_allocator, chunk_size(capacity));
+      for (int j = 0 ; j < chunk_size(capacity) ; j++)
+      {
+        new (chunk + j) Buckets(Rebind<Entry>(_allocator));
+      }
+    }
+    return chunk[i & (TABLE_CHUNK - 1)];
+  }
+
+  void delete_chunk(Buckets **table, int capacity, int chunk)
+  {
+    if (table[chunk] == nullptr)
+    {
+      return;
+    }
+    for (int j = 0 ; j < chunk_size(capacity) ; j++)
+    {
+      table[chunk][j].~Buckets();
+    }
+    Rebind<Buckets> chunk_allocator(_allocator);
+    std::allocator_traits<Rebind<Buckets>>::deallocate
+        (chunk_allocator, table[chunk], chunk_size(capacity));
+    table[chunk] = nullptr;
+  }
+
+  void delete_table(Buckets **table, int capacity)
+  {
+    if (table == nullptr)
+    {
+      return;
+    }
+    for (int i = 0 ; i < chunk_count(capacity) ; i++)
+    {
+      delete_chunk(table, capacity, i);
+    }
+    Rebind<Buckets *> chunks_allocator(_allocator);
+    std::allocator_traits<Rebind<Buckets *>>::deallocate
+        (chunks_allocator, table, chunk_count(capacity));
+  }
+
+  std::atomic<int>* new_references()
+  {
+    Rebind<std::atomic<int>> counter_allocator(_allocator);
+    std::atomic<int> *references = std::allocator_traits<
+        Rebind<std::atomic<int>>>::allocate(counter_allocator, 1);
+    return new (references) std::atomic<int>(1);
+  }
+
+  // A new table holding copies of the occupied buckets of table.
+  Buckets** clone_table(Buckets **table, int capacity,
+                       const Bitmap &occupied)
+  {
+    if (table == nullptr)
+    {
+      return nullptr;
+    }
+    Buckets **copy = new_table(capacity);
+    for (int i = next_set_bit(occupied, 0, capacity) ; i < capacity ;
+         i = next_set_bit(occupied, i + 1, capacity))
+    {
+      chunk_bucket(copy, capacity, i) = bucket_in(table, i);
+    }
+    return copy;
+  }
+
+  // Gives up this map's share of the tables, freeing them if it was the last.
+  void drop_tables(Buckets **table, int capacity, Buckets **old_table,
+                   int old_capacity, std::atomic<int> *references)
+  {
+    if (references->fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      delete_table(table, capacity);
+      delete_table(old_table, old_capacity);
+      Rebind<std::atomic<int>> counter_allocator(_allocator);
+      std::allocator_traits<Rebind<std::atomic<int>>>::deallocate
+          (counter_allocator, references, 1);
+    }
+  }
+
+  bool shared() const
+  {
+    return _references != nullptr &&
+           _references->load(std::memory_order_acquire) != 1;
+  }
+
+  // Called before anything modifies the tables: copies them if other maps
+  // share them.
+  void detach()
+  {
+    if (!shared())
+    {
+      return;
+    }
+    Buckets **table = _table, **old_table = _old_table;
+    std::atomic<int> *references = _references;
+    _table = clone_table(table, _capacity, _occupied);
+    _old_table = clone_table(old_table, _old_capacity, _old_occupied);
+    _references = new_references();
+    drop_tables(table, _capacity, old_table, _old_capacity, references);
+  }
+
+  // The key's pair, found by a lookup, in tables this map doesn't share, so
+  // that it may be modified: the same pair, or its copy after detaching.
+  template <typename K>
+  PairT* own_pair(PairT *pair, const K &key)
+  {
+    if (!shared())
+    {
+      return pair;
+    }
+    detach();
+    return &locate(key, _hasher(key))->pair;
+  }
+
+  static void set_bit(Bitmap &bitmap, int i, bool value)
+  {
+    uint64_t mask = (uint64_t) 1 << (i % BITMAP_WORD_BITS);
+    if (value)
+    {
+      bitmap[i / BITMAP_WORD_BITS] |= mask;
+    }
+    else
+    {
+      bitmap[i / BITMAP_WORD_BITS] &= ~mask;
+    }
+  }
+
+  void set_occupied(int i, bool occupied)
+  {
+    if (i < _capacity)
+    {
+      set_bit(_occupied, i, occupied);
+    }
+    else
+    {
+      set_bit(_old_occupied, i - _capacity, occupied);
+    }
+  }
+
+  // The first set bit at or after from, or size if there is none.
+  static int next_set_bit(const Bitmap &bitmap, int from, int size)
+  {
+    if (from >= size)
+    {
+      return size;
+    }
+    size_t word = from / BITMAP_WORD_BITS;
+    uint64_t bits = bitmap[word] & (~(uint64_t) 0 << (from % BITMAP_WORD_BITS));
+    while (bits == 0)
+    {
+      if (++word == bitmap.size())
+      {
+        return size;
+      }
+      bits = bitmap[word];
+    }
+    return (int) (word * BITMAP_WORD_BITS) + __builtin_ctzll(bits);
+  }
+
+  // The first non-empty bucket at or after i, or bucket_count() if none.
+  int next_occupied(int i) const
+  {
+    if (_table == nullptr)
+    {
+      return i == 0 && _size > 0 ? 0 : 1;
+    }
+    if (i < _capacity)
+    {
+      i = next_set_bit(_occupied, i, _capacity);
+      if (i < _capacity)
+      {
+        return i;
+      }
+    }
+    return _capacity + next_set_bit(_old_occupied, i - _capacity,
+                                    _old_capacity);
+  }
+
+  // The key's entry, or nullptr if the key is missing. O(bucket size)
+  template <typename K>
+  Entry* find_key(const K &key) const
+  {
+    Entry *entry;
+    if (_table == nullptr)
+    {
+      entry = find_inline(key);
+    }
+    else
+    {
+      size_t key_hash = _hasher(key);
+      entry = find_entry(bucket_of(key_hash), key_hash, key);
+    }
+    count_lookup(entry != nullptr);
+    return entry;
+  }
+
+  static const ValueT* value_of(const Entry *entry)
+  { return entry == nullptr ? nullptr : &entry->pair.second; }
+
+  template <typename K>
+  Entry* find_inline(const K &key) const
+  {
+    Entry *entries = _inline.data();
+    for (int i = 0 ; i < _size ; i++)
+    {
+      if (_key_equal(entries[i].pair.first, key))
+      {
+        return &entries[i];
+      }
+    }
+    return nullptr;
+  }
+
+  template <typename K>
+  Entry* find_entry(Buckets *bucket, size_t key_hash, const K &key) const
+  {
+    if (bucket == nullptr)
+    {
+      return nullptr;
+    }
+    for (Entry &entry : *bucket)
+    {
+      if (entry.may_match(key_hash) && _key_equal(entry.pair.first, key))
+      {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  template <typename ForwardIt, typename F>
+  void resolve_many(ForwardIt first, ForwardIt last, F on_entry) const;
+
+  // The key's entry without counting the lookup, or nullptr.
+  template <typename K>
+  Entry* locate(const K &key, size_t key_hash) const
+  {
+    return _table == nullptr ? find_inline(key) :
+           find_entry(bucket_of(key_hash), key_hash, key);
+  }
+
+  // Probes the key's bucket once; if the key is missing, constructs the
+  // entry from pair_args before anything else, since they may refer to
+  // entries of this map that detaching, migrating or growing moves or frees.
+  // The entry is then moved into its final bucket. A found pair may still be
+  // shared: callers that modify it get it through own_pair.
+  template <typename K, typename... Args>
+  std::pair<PairT *, bool> find_or_emplace(const K &key, Args &&... pair_args)
   {
-    Buckets& cur_bucket = _table[hash(key)];
-    for (IterT it = cur_bucket.begin(); it != cur_bucket.end(); it++)
+    size_t key_hash = _hasher(key);
+    Entry *found = locate(key, key_hash);
+    count_lookup(found != nullptr);
+    if (found != nullptr)
+    {
+      return {&found->pair, false};
+    }
+    Entry entry(key_hash, std::forward<Args> (pair_args)...);
+    detach ();
+    migrate_buckets (MIGRATION_STEP);
+    if (_table == nullptr)
     {
-      if (it->first == key)
+      if (_size < InlineCapacity)
       {
-        return it;
+        Entry *inline_entry = new (_inline.data() + _size)
+            Entry(std::move(entry));
+        _size++;
+        return {&inline_entry->pair, true};
       }
+      spill();
     }
-    return _null_iter;
+    grow_before_insert ();
+    int position = bucket_position(key_hash);
+    Buckets &bucket = occupy(position);
+    bucket.push_back (std::move (entry));
+    _size++;
+    return {&bucket.back ().pair, true};
+  }
+
+  template <typename K>
+  bool erase_key(const K &key, ValueT *erased_value = nullptr);
+
+  // Erases the key without resizing, detaching only if it is there, and
+  // moves its value to erased_value if that isn't null; returns false if
+  // the key is missing.
+  template <typename K>
+  bool remove_key(const K &key, ValueT *erased_value = nullptr);
+
+  template <typename K>
+  const ValueT& value_at(const K &key) const;
+
+  template <typename K>
+  ValueT& value_at(const K &key);
+
+  // The key's value, in tables this map doesn't share, or nullptr.
+  template <typename K>
+  ValueT* value_ptr(const K &key);
+
+  // The value of a pair find_or_emplace returned, made safe to modify.
+  template <typename K>
+  std::pair<ValueT *, bool> owned_value(const K &key,
+                                        std::pair<PairT *, bool> result)
+  {
+    PairT *pair = result.second ? result.first : own_pair(result.first, key);
+    _unshareable = true;
+    return {&pair->second, result.second};
+  }
+
+  template <typename K>
+  ValueT value_or_default(const K &key) const;
+
+  template <typename K>
+  ValueT& value_or_insert(const K &key);
+
+  template <typename K>
+  int key_bucket_index(const K &key) const;
+
+  template <typename K>
+  int key_bucket_size(const K &key) const
+  {
+    key_bucket_index(key); // throws if the key is missing.
+    return _table == nullptr ? _size : bucket_of(_hasher(key))->size();
+  }
+
+  // Moves the inline entries into a newly allocated table, already as large
+  // as the insert that spills them needs, so that it doesn't rehash them
+  // right away.
+  void spill()
+  {
+    int capacity = _capacity;
+    bool changed = false;
+    handle_insert (capacity, changed, _size + 1);
+    Entry *entries = _inline.data();
+    allocate_table(capacity);
+    for (int i = 0 ; i < _size ; i++)
+    {
+      int index = entries[i].hash_code(_hasher) & (_capacity - 1);
+      occupy(index).push_back(std::move(entries[i]));
+      entries[i].~Entry();
+    }
+    _unshareable = false; // the references were to the inline entries.
+  }
+
+  // Frees (or stops sharing) the tables or destroys the inline entries,
+  // leaving no entries and no table.
+  void release()
+  {
+    if (_table == nullptr)
+    {
+      for (int i = 0 ; i < _size ; i++)
+      {
+        _inline.data()[i].~Entry();
+      }
+    }
+    else
+    {
+      drop_tables(_table, _capacity, _old_table, _old_capacity, _references);
+    }
+    _table = _old_table = nullptr;
+    _references = nullptr;
+    _unshareable = false;
+    _old_capacity = _migrated = 0;
+    _occupied.clear();
+    _old_occupied.clear();
+    _size = 0;
   }
 
   void rehash(int new_cap)
   {
-    auto *new_hashtable = new Buckets[new_cap];
-    for (const_iterator it = cbegin() ; it != cend() ; ++it)
+    if (_table == nullptr)
+    {
+      _capacity = new_cap; // the table will be allocated at that size.
+      return;
+    }
+    detach();
+    RehashTimer timer(*this);
+    _rehashes += _stats_enabled;
+    finish_migration();
+    Buckets **old_table = _table;
+    int old_capacity = _capacity;
+    Bitmap old_occupied = std::move(_occupied);
+    allocate_table(new_cap);
+    if (_incremental_rehash && _size > 0)
+    {
+      _old_table = old_table;
+      _old_capacity = old_capacity;
+      _old_occupied = std::move(old_occupied);
+      _migrated = 0;
+      migrate_buckets(MIGRATION_STEP);
+      return;
+    }
+    for (int i = next_set_bit(old_occupied, 0, old_capacity) ;
+         i < old_capacity ; i = next_set_bit(old_occupied, i + 1, old_capacity))
+    {
+      for (Entry &entry : bucket_in(old_table, i))
+      {
+        int index = entry.hash_code(_hasher) & (_capacity - 1);
+        occupy(index).push_back(std::move(entry));
+      }
+    }
+    delete_table(old_table, old_capacity);
+    _unshareable = false; // no reference points into the new table.
+  }
+
+  void migrate_buckets(int count)
+  {
+    if (_old_table == nullptr)
+    {
+      return;
+    }
+    detach();
+    RehashTimer timer(*this);
+    for (; count > 0 && _migrated < _old_capacity ; count--, _migrated++)
+    {
+      int position = _capacity + _migrated;
+      if (occupied(position))
+      {
+        Buckets &bucket = bucket_at(position);
+        for (Entry &entry : bucket)
+        {
+          int index = entry.hash_code(_hasher) & (_capacity - 1);
+          occupy(index).push_back(std::move(entry));
+        }
+        Buckets(Rebind<Entry>(_allocator)).swap(bucket); // frees its storage.
+        set_occupied(position, false);
+      }
+      // The old table is freed a chunk at a time as it is moved, rather
+      // than all at once by the step that ends the migration.
+      if ((_migrated + 1) % chunk_size(_old_capacity) == 0)
+      {
+        delete_chunk(_old_table, _old_capacity,
+                     _migrated >> TABLE_CHUNK_BITS);
+      }
+    }
+    if (_migrated == _old_capacity)
+    {
+      delete_table(_old_table, _old_capacity);
+      _old_table = nullptr;
+      _old_occupied.clear();
+      _old_capacity = 0;
+      _migrated = 0;
+    }
+  }
+
+  void finish_migration()
+  { migrate_buckets (_old_capacity); }
+
+  void grow_before_insert()
+  {
+    int next_capacity = _capacity;
+    bool changed = false;
+    handle_insert (next_capacity, changed, _size + 1);
+    if (changed)
     {
-      new_hashtable[hash(it->first, new_cap)].push_back(PairT(it->first,
-                                                      it->second));
+      rehash(next_capacity);
     }
-    delete [] _table;
-    _table = new_hashtable;
-    _capacity = new_cap;
   }
 
   void rebalance(bool insert)
@@ -116,7 +1116,7 @@ class HashMap
     bool changed = false;
     if (insert)
     {
-      handle_insert (next_capacity, changed);
+      handle_insert (next_capacity, changed, _size);
     }
     else
     {
@@ -128,10 +1128,11 @@ class HashMap
     }
   }
 
-  void handle_insert (int &next_capacity, bool &changed) const
+  void handle_insert (int &next_capacity, bool &changed, int new_size) const
   {
-    double cur_load_factor = get_load_factor();
-    while (cur_load_factor > UPPER_LOAD_FACTOR)
+    double cur_load_factor = (double) new_size / (double) _capacity;
+    while (cur_load_factor > _upper_load_factor ||
+           next_capacity < _min_capacity)
     {
       changed = true;
       next_capacity *= GROWTH_FACTOR;
@@ -139,28 +1140,75 @@ class HashMap
     }
   }
 
+  // Shrinks only while the smaller table could still take one more entry
+  // without growing back, so erasing and inserting around a boundary (or
+  // around an empty table) doesn't rehash on every operation.
   void handle_erase (int &next_capacity, bool &changed) const
   {
     double cur_load_factor = get_load_factor();
-    while (cur_load_factor < LOWER_LOAD_FACTOR && cur_load_factor != 0)
+    while (cur_load_factor < _lower_load_factor &&
+           next_capacity / GROWTH_FACTOR >= _min_capacity &&
+           _size + 1 <= _upper_load_factor * (next_capacity / GROWTH_FACTOR))
     {
       changed = true;
       next_capacity /= GROWTH_FACTOR;
       cur_load_factor *= GROWTH_FACTOR;
     }
-    if (next_capacity < MINIMAL_CAPACITY || cur_load_factor == 0)
+  }
+
+  // The smallest capacity, doubled from INITIAL_CAPACITY, that holds n
+  // entries within the upper load factor.
+  int capacity_for(int n) const
+  {
+    int capacity = INITIAL_CAPACITY;
+    while (n > _upper_load_factor * capacity)
     {
-      changed = true;
-      next_capacity = MINIMAL_CAPACITY;
+      capacity *= GROWTH_FACTOR;
     }
+    return capacity;
   }
 
-  void fill_table(const HashMap<KeyT, ValueT>& other)
+  void copy_settings(const HashMap &other)
   {
-    for (const_iterator it = other.cbegin() ; it != other.cend() ; it++)
+    _min_capacity = other._min_capacity;
+    _lower_load_factor = other._lower_load_factor;
+    _upper_load_factor = other._upper_load_factor;
+    _incremental_rehash = other._incremental_rehash;
+    _stats_enabled = other._stats_enabled;
+  }
+
+  // Makes this empty map a copy of other's entries: shares its tables if
+  // either map may free them, copies them otherwise.
+  void copy_entries(const HashMap &other)
+  {
+    _capacity = other._capacity;
+    _old_capacity = other._old_capacity;
+    _migrated = other._migrated;
+    _occupied = other._occupied;
+    _old_occupied = other._old_occupied;
+    if (other._table == nullptr)
+    {
+      for ( ; _size < other._size ; _size++)
+      {
+        new (_inline.data() + _size) Entry(other._inline.data()[_size]);
+      }
+      return;
+    }
+    if (!other._unshareable && _allocator == other._allocator)
     {
-      insert(it->first, it->second);
+      _table = other._table;
+      _old_table = other._old_table;
+      _references = other._references;
+      _references->fetch_add(1, std::memory_order_relaxed);
     }
+    else
+    {
+      _table = clone_table(other._table, _capacity, _occupied);
+      _old_table = clone_table(other._old_table, _old_capacity,
+                               _old_occupied);
+      _references = new_references();
+    }
+    _size = other._size;
   }
 
  public:
@@ -174,7 +1222,7 @@ class HashMap
     using difference_type = std::ptrdiff_t;
     using iterator_category = std::forward_iterator_tag;
 
-    ConstIterator(const HashMap<KeyT, ValueT>& hm, int bucket_i, int pair_i);
+    ConstIterator(const HashMap& hm, int bucket_i, int pair_i);
 
     ConstIterator& operator++();
 
@@ -186,28 +1234,14 @@ class HashMap
     { return !operator== (other); }
 
     reference operator*()
-    { return _hash_map._table[_bucket_index].operator[](_pair_index); }
+    { return _hash_map.entry_at(_bucket_index, _pair_index).pair; }
 
     pointer operator->() { return &(operator*()); }
 
    protected:
-    friend class HashMap<KeyT, ValueT>;
-    const HashMap<KeyT, ValueT>& _hash_map;
+    friend class HashMap;
+    const HashMap& _hash_map;
     int _bucket_index, _pair_index;
-
-    void skip_empty_buckets (Buckets &cur_bucket)
-    {
-      while (_bucket_index != _hash_map._capacity)
-      {
-        cur_bucket = _hash_map._table[_bucket_index];
-        if (!cur_bucket.empty())
-        {
-          break;
-        }
-        _bucket_index++;
-        _pair_index = 0;
-      }
-    }
   };
 
   using const_iterator = ConstIterator;
@@ -219,170 +1253,456 @@ class HashMap
   { return ConstIterator(*this, 0, 0); }
 
   const_iterator end() const
-  { return ConstIterator(*this, _capacity, 0); }
+  { return ConstIterator(*this, bucket_count(), 0); }
 
   const_iterator cend() const
-  { return ConstIterator(*this, _capacity, 0); }
+  { return ConstIterator(*this, bucket_count(), 0); }
 };
 
-template <typename KeyT, typename ValueT>
-HashMap<KeyT, ValueT>::HashMap() :_size(0), _capacity(INITIAL_CAPACITY)
+namespace pmr
 {
-  _table = new Buckets[_capacity];
+// A HashMap whose tables come from a std::pmr::memory_resource, e.g. a
+// std::pmr::monotonic_buffer_resource that lives as long as a request.
+template <typename KeyT, typename ValueT, typename Hash = HashMapHash<KeyT>,
+          typename KeyEqual = std::equal_to<>>
+using HashMap = ::HashMap<KeyT, ValueT, Hash, KeyEqual, 0,
+    std::pmr::polymorphic_allocator<std::pair<KeyT, ValueT>>>;
 }
 
-template <typename KeyT, typename ValueT>
-HashMap<KeyT, ValueT>::HashMap(const std::vector<KeyT> &keys,
-                               const std::vector<ValueT> &values)
+// A HashMap for maps that mostly hold a handful of entries: up to N of them
+// live in the object, and only a larger map allocates its table.
+template <typename KeyT, typename ValueT, int N = SMALL_MAP_CAPACITY>
+using SmallHashMap = HashMap<KeyT, ValueT, HashMapHash<KeyT>, std::equal_to<>,
+                             N>;
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::HashMap()
+: _size(0), _capacity(INITIAL_CAPACITY) {}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::HashMap
+(const Allocator &allocator)
+: _allocator(allocator), _size(0), _capacity(INITIAL_CAPACITY) {}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::HashMap
+(const Hash &hasher, const KeyEqual &key_equal, const Allocator &allocator)
+: _hasher(hasher), _key_equal(key_equal), _allocator(allocator), _size(0),
+  _capacity(INITIAL_CAPACITY) {}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::HashMap
+(const std::vector<KeyT> &keys, const std::vector<ValueT> &values,
+ const Allocator &allocator)
+: _allocator(allocator)
 {
   if (keys.size() != values.size())
   {
     throw std::invalid_argument(INVALID_KEYS_VALUES_ERROR);
   }
+  // Sized once for all the pairs, so placing them never rehashes.
   _size = 0;
-  _capacity = INITIAL_CAPACITY;
-  _table = new Buckets[_capacity];
+  _capacity = capacity_for((int) keys.size());
   for (int i = 0 ; i < (int) keys.size() ; i++)
   {
-    if(!insert(keys[i], values[i]))
-    {
-      operator[] (keys[i]) = values[i];
-    }
+    insert_or_assign(keys[i], values[i]);
   }
 }
 
-template <typename KeyT, typename ValueT>
-HashMap<KeyT, ValueT>::HashMap(const HashMap<KeyT, ValueT> &other)
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::HashMap
+(const HashMap &other)
+: _hasher(other._hasher), _key_equal(other._key_equal),
+  _allocator(std::allocator_traits<Allocator>::
+             select_on_container_copy_construction(other._allocator))
 {
-  _capacity = other._capacity;
   _size = 0;
-  _table = new Buckets[_capacity];
-  fill_table(other);
+  copy_settings(other);
+  copy_entries(other);
 }
-template <typename KeyT, typename ValueT>
-HashMap<KeyT, ValueT>::~HashMap()
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::~HashMap()
 {
-  delete[] _table;
-  delete _empty_table;
+  release();
 }
 
-template <typename KeyT, typename ValueT>
-HashMap<KeyT, ValueT>& HashMap<KeyT, ValueT>::operator=
-                                            (const HashMap<KeyT,ValueT> &other)
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>&
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::operator=
+(const HashMap &other)
 {
   if (this != &other)
   {
-    clear();
-    _capacity = other._capacity;
-    _table = new Buckets[_capacity];
-    fill_table (other);
+    release();
+    if constexpr (std::allocator_traits<Allocator>::
+                  propagate_on_container_copy_assignment::value)
+    {
+      _allocator = other._allocator;
+      _occupied = Bitmap(_allocator);
+      _old_occupied = Bitmap(_allocator);
+    }
+    _hasher = other._hasher;
+    _key_equal = other._key_equal;
+    copy_settings(other);
+    copy_entries(other);
   }
   return *this;
 }
 
-template <typename KeyT, typename ValueT>
-bool HashMap<KeyT, ValueT>::insert(const KeyT &key, const ValueT &value)
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename... Args>
+bool HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::emplace
+(Args &&... args)
+{
+  PairT pair(std::forward<Args>(args)...);
+  return find_or_emplace(pair.first, std::move(pair)).second;
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename... Args>
+bool
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::try_emplace
+(const KeyT &key, Args &&... args)
+{
+  return find_or_emplace(key, std::piecewise_construct,
+                         std::forward_as_tuple(key),
+                         std::forward_as_tuple(std::forward<Args>(args)...))
+                         .second;
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename... Args>
+bool
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::try_emplace
+(KeyT &&key, Args &&... args)
+{
+  return find_or_emplace(key, std::piecewise_construct,
+                         std::forward_as_tuple(std::move(key)),
+                         std::forward_as_tuple(std::forward<Args>(args)...))
+                         .second;
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename M>
+bool
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::insert_or_assign(const KeyT &key, M &&value)
+{
+  std::pair<PairT *, bool> result = find_or_emplace(key, key,
+                                                    std::forward<M>(value));
+  if (!result.second)
+  {
+    own_pair(result.first, key)->second = std::forward<M>(value);
+  }
+  return result.second;
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename M>
+bool
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::insert_or_assign(KeyT &&key, M &&value)
+{
+  std::pair<PairT *, bool> result = find_or_emplace(key, std::move(key),
+                                                    std::forward<M>(value));
+  if (!result.second)
+  {
+    own_pair(result.first, key)->second = std::forward<M>(value);
+  }
+  return result.second;
+}
+
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename K>
+bool HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::erase_key
+(const K &key, ValueT *erased_value)
 {
-  IterT iter_pos = get_iterator_position_on_bucket(key);
-  if (iter_pos != _null_iter)
+  if (!remove_key(key, erased_value))
   {
     return false;
   }
-  _table[hash(key)].push_back(PairT (key, value));
-  _size++;
-  rebalance (true);
+  migrate_buckets(MIGRATION_STEP);
+  rebalance(false);
   return true;
 }
 
-
-template <typename KeyT, typename ValueT>
-bool HashMap<KeyT, ValueT>::erase(const KeyT &key)
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename K>
+bool
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::remove_key(const K &key, ValueT *erased_value)
 {
-  IterT iter_pos = get_iterator_position_on_bucket(key);
-  if (iter_pos == _null_iter)
+  Entry *entry = find_key(key);
+  if (entry == nullptr)
   {
     return false;
   }
-  _table[hash(key)].erase(iter_pos);
+  if (shared())
+  {
+    detach();
+    entry = locate(key, _hasher(key));
+  }
+  if (erased_value != nullptr)
+  {
+    *erased_value = std::move(entry->pair.second);
+  }
+  if (_table == nullptr)
+  {
+    // The last inline entry takes the erased one's place.
+    Entry *last = _inline.data() + _size - 1;
+    if (entry != last)
+    {
+      *entry = std::move(*last);
+    }
+    last->~Entry();
+  }
+  else
+  {
+    int position = bucket_position(_hasher(key));
+    Buckets &bucket = bucket_at(position);
+    bucket.erase(bucket.begin() + (entry - bucket.data()));
+    if (bucket.empty())
+    {
+      set_occupied(position, false);
+    }
+  }
   _size--;
-  rebalance(false);
   return true;
 }
 
-template <typename KeyT, typename ValueT>
-const ValueT& HashMap<KeyT, ValueT>::at(const KeyT &key) const
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename InputIt>
+int HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::erase
+(InputIt first, InputIt last)
 {
-  IterT iter_pos = get_iterator_position_on_bucket(key);
-  if (iter_pos == _null_iter)
+  int erased = 0;
+  for ( ; first != last ; ++first)
   {
-    throw std::out_of_range(KEY_ERROR);
+    erased += remove_key(*first);
+  }
+  if (erased > 0)
+  {
+    migrate_buckets(MIGRATION_STEP);
+    rebalance(false);
+  }
+  return erased;
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename Pred>
+int
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::erase_if
+(Pred pred)
+{
+  detach();
+  int erased = 0;
+  if (_table == nullptr)
+  {
+    // Compacts the kept inline entries to the front.
+    Entry *entries = _inline.data();
+    int kept = 0;
+    for (int i = 0 ; i < _size ; i++)
+    {
+      if (!pred(std::as_const(entries[i].pair)))
+      {
+        if (kept != i)
+        {
+          entries[kept] = std::move(entries[i]);
+        }
+        kept++;
+      }
+    }
+    for (int i = kept ; i < _size ; i++)
+    {
+      entries[i].~Entry();
+    }
+    erased = _size - kept;
+  }
+  else
+  {
+    for (int i = next_occupied(0) ; i < bucket_count() ;
+         i = next_occupied(i + 1))
+    {
+      Buckets &bucket = bucket_at(i);
+      IterT end = std::remove_if(bucket.begin(), bucket.end(),
+                                 [&pred](const Entry &entry)
+                                 { return pred(std::as_const(entry.pair)); });
+      erased += bucket.end() - end;
+      bucket.erase(end, bucket.end());
+      if (bucket.empty())
+      {
+        set_occupied(i, false);
+      }
+    }
+  }
+  _size -= erased;
+  if (erased > 0)
+  {
+    rebalance(false);
+  }
+  return erased;
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename ForwardIt, typename F>
+void
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::resolve_many(ForwardIt first, ForwardIt last,
+                                 F on_entry) const
+{
+  if (_table == nullptr)
+  {
+    for ( ; first != last ; ++first)
+    {
+      on_entry(find_key(*first));
+    }
+    return;
+  }
+  size_t hashes[PREFETCH_DISTANCE];
+  Buckets *buckets[PREFETCH_DISTANCE];
+  ForwardIt ahead = first;
+  size_t hashed = 0, touched = 0, resolved = 0;
+  while (first != last)
+  {
+    for ( ; ahead != last && hashed - resolved < PREFETCH_DISTANCE ;
+         ++ahead, ++hashed)
+    {
+      size_t slot = hashed % PREFETCH_DISTANCE;
+      hashes[slot] = _hasher(*ahead);
+      buckets[slot] = bucket_of(hashes[slot]);
+      __builtin_prefetch(buckets[slot]);
+    }
+    for ( ; touched < hashed && touched - resolved < PREFETCH_DISTANCE / 2 ;
+         ++touched)
+    {
+      Buckets *bucket = buckets[touched % PREFETCH_DISTANCE];
+      if (bucket != nullptr)
+      {
+        __builtin_prefetch(bucket->data());
+      }
+    }
+    size_t slot = resolved % PREFETCH_DISTANCE;
+    const Entry *entry = find_entry(buckets[slot], hashes[slot], *first);
+    count_lookup(entry != nullptr);
+    on_entry(entry);
+    ++first;
+    ++resolved;
   }
-  return iter_pos->second;
 }
 
-template <typename KeyT, typename ValueT>
-ValueT& HashMap<KeyT, ValueT>::at(const KeyT &key)
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename K>
+const ValueT&
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::value_at
+(const K &key) const
 {
-  IterT iter_pos = get_iterator_position_on_bucket(key);
-  if (iter_pos == _null_iter)
+  Entry *entry = find_key(key);
+  if (entry == nullptr)
   {
     throw std::out_of_range(KEY_ERROR);
   }
-  return iter_pos->second;
+  return entry->pair.second;
 }
 
-template <typename KeyT, typename ValueT>
-const ValueT HashMap<KeyT, ValueT>::operator[](const KeyT &key) const
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename K>
+ValueT&
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::value_at(const K &key)
 {
-  IterT iter_pos = get_iterator_position_on_bucket(key);
-  if (iter_pos != _null_iter)
+  ValueT *value = value_ptr(key);
+  if (value == nullptr)
   {
-    return iter_pos->second;
+    throw std::out_of_range(KEY_ERROR);
   }
-  return ValueT();
+  return *value;
 }
 
-template <typename KeyT, typename ValueT>
-ValueT& HashMap<KeyT, ValueT>::operator[](const KeyT &key)
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename K>
+ValueT*
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::value_ptr(const K &key)
 {
-  IterT iter_pos = get_iterator_position_on_bucket(key);
-  if (iter_pos != _null_iter)
+  Entry *entry = find_key(key);
+  if (entry == nullptr)
   {
-    return iter_pos->second;
+    return nullptr;
   }
-  else
+  // The value may be written through the pointer; reads that shouldn't
+  // copy shared tables go through the const overloads.
+  PairT *pair = own_pair(&entry->pair, key);
+  _unshareable = true;
+  return &pair->second;
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename K>
+ValueT
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::value_or_default(const K &key) const
+{
+  Entry *entry = find_key(key);
+  if (entry != nullptr)
   {
-    insert(key, ValueT());
-    iter_pos = get_iterator_position_on_bucket (key);
-    return iter_pos->second; //return ValueT()
+    return entry->pair.second;
   }
+  return ValueT();
 }
 
-template <typename KeyT, typename ValueT>
-bool HashMap<KeyT, ValueT>::operator==(const HashMap<KeyT, ValueT>& other)const
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename K>
+ValueT&
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::value_or_insert(const K &key)
+{
+  PairT *pair = own_pair(find_or_emplace(key, std::piecewise_construct,
+                                         std::forward_as_tuple(key),
+                                         std::forward_as_tuple()).first, key);
+  _unshareable = true;
+  return pair->second;
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+bool
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::operator==
+(const HashMap& other)const
 {
   if (_size != other._size)
   {
     return false;
   }
+  // Keys are unique and the sizes match, so checking that every pair of other
+  // is in this map covers the other direction too.
   for (const_iterator it =  other.cbegin(); it != other.cend(); it++)
   {
-    if ( !contains_key( it->first ) )
-    {
-      return false;
-    }
-    if ( at( it->first ) != it->second )
-    {
-      return false;
-    }
-  }
-  for (const_iterator it = cbegin(); it != cend(); it++ )
-  {
-    if ( !other.contains_key( it->first ) )
-    {
-      return false;
-    }
-    if (other.at(it->first) != at (it->first))
+    Entry *entry = find_key(it->first);
+    if (entry == nullptr || entry->pair.second != it->second)
     {
       return false;
     }
@@ -390,66 +1710,143 @@ bool HashMap<KeyT, ValueT>::operator==(const HashMap<KeyT, ValueT>& other)const
   return true;
 }
 
-template <typename KeyT, typename ValueT>
-int HashMap<KeyT, ValueT>::bucket_index(const KeyT &key) const
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+template <typename K>
+int
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::key_bucket_index(const K &key) const
 {
-  if (!contains_key(key))
+  if (locate(key, _hasher(key)) == nullptr) // not a lookup for the stats.
   {
     throw std::invalid_argument(KEY_ERROR);
   }
-  return hash(key);
+  // Numbered as bucket_size and the iterators number them: the inline
+  // entries are bucket 0, and a key not migrated yet is in the old table.
+  return _table == nullptr ? 0 : bucket_position(_hasher(key));
 }
 
-template <typename KeyT, typename ValueT>
-void HashMap<KeyT, ValueT>::clear()
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+void
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::set_load_factors(double lower, double upper)
 {
-  delete[] _table;
-  _table = new Buckets[_capacity];
-  _size = 0;
+  if (lower < 0 || upper <= 0 || lower * GROWTH_FACTOR >= upper)
+  {
+    throw std::invalid_argument(INVALID_LOAD_FACTORS_ERROR);
+  }
+  _lower_load_factor = lower;
+  _upper_load_factor = upper;
+  rebalance(true);
+  rebalance(false);
 }
 
-template <typename KeyT, typename ValueT>
-HashMap<KeyT, ValueT>::ConstIterator::ConstIterator
-(const HashMap<KeyT, ValueT> &hm, int bucket_i, int pair_i)
-: _hash_map(hm), _bucket_index(bucket_i), _pair_index(pair_i)
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+void
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::reserve(int n)
 {
-  if (_bucket_index != _hash_map._capacity)
+  _min_capacity = n > 0 ? capacity_for(n) : MINIMAL_CAPACITY;
+  rebalance(true);
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+void
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::set_incremental_rehash(bool incremental)
+{
+  _incremental_rehash = incremental;
+  if (!incremental)
   {
-    Buckets cur_bucket = _hash_map._table[_bucket_index];
-    skip_empty_buckets (cur_bucket);
+    finish_migration();
   }
 }
 
-template <typename KeyT, typename ValueT>
-typename HashMap<KeyT, ValueT>::ConstIterator&
-HashMap<KeyT,ValueT>::ConstIterator::operator++ ()
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+HashMapStats
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::stats() const
 {
-  Buckets cur_bucket = _hash_map._table[_bucket_index];
-  if (++_pair_index >= (int) cur_bucket.size())
+  HashMapStats stats{_size, _capacity, get_load_factor(), _hits, _misses,
+                     _rehashes, _rehash_ms, 0, 0, {}};
+  stats.heap_bytes = (_occupied.capacity() + _old_occupied.capacity()) *
+                     sizeof(uint64_t);
+  for (int i = 0 ; i < bucket_count() ; i++)
   {
-    _pair_index = 0;
-    _bucket_index++;
+    int length = _table == nullptr ? _size : 0;
+    const Buckets *bucket = _table == nullptr ? nullptr : allocated_bucket(i);
+    if (bucket != nullptr)
+    {
+      length = bucket->size();
+      stats.heap_bytes += sizeof(Buckets) + bucket->capacity() *
+                                            sizeof(Entry);
+    }
+    if (length >= (int) stats.chain_histogram.size())
+    {
+      stats.chain_histogram.resize(length + 1, 0);
+    }
+    stats.chain_histogram[length]++;
+    stats.max_chain = std::max(stats.max_chain, length);
+  }
+  return stats;
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+void HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity, Allocator>::clear()
+{
+  release();
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::ConstIterator::
+ConstIterator(const HashMap &hm, int bucket_i, int pair_i)
+: _hash_map(hm), _bucket_index(bucket_i), _pair_index(pair_i)
+{
+  if (_pair_index == 0)
+  {
+    _bucket_index = _hash_map.next_occupied(_bucket_index);
   }
-  if(_bucket_index == _hash_map._capacity)
+}
+
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+typename HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+                 Allocator>::ConstIterator&
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::ConstIterator::operator++ ()
+{
+  if (++_pair_index >= _hash_map.entries_in(_bucket_index))
   {
-    return *this;
+    _pair_index = 0;
+    _bucket_index = _hash_map.next_occupied(_bucket_index + 1);
   }
-  skip_empty_buckets (cur_bucket);
   return *this;
 }
 
-template <typename KeyT, typename ValueT>
-typename HashMap<KeyT, ValueT>::ConstIterator
-HashMap<KeyT,ValueT>::ConstIterator::operator++ (int)
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+typename HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+                 Allocator>::ConstIterator
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::ConstIterator::operator++ (int)
 {
 ConstIterator cur_it = *this;
 operator++();
 return cur_it;
 }
 
-template <typename KeyT, typename ValueT>
-bool HashMap<KeyT, ValueT>::ConstIterator::operator==
-                                          (const ConstIterator &other) const
+template <typename KeyT, typename ValueT, typename Hash, typename KeyEqual,
+          int InlineCapacity, typename Allocator>
+bool
+HashMap<KeyT, ValueT, Hash, KeyEqual, InlineCapacity,
+        Allocator>::ConstIterator::operator==(const ConstIterator &other) const
 {
   return ((&_hash_map == &other._hash_map) &&
   (_bucket_index == other._bucket_index) &&
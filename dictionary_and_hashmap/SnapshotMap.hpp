@@ -0,0 +1,276 @@
+#ifndef _SNAPSHOT_MAP_HPP_
+#define _SNAPSHOT_MAP_HPP_
+
+#include "Dictionary.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#define CACHE_LINE_SIZE 64
+
+// Epoch-based reclamation shared by all the SnapshotMaps. Every thread that
+// reads owns a record holding the global epoch it entered its read with; a
+// retired snapshot can be freed once every reading thread entered after it
+// was retired.
+class EpochRegistry
+{
+ public:
+  static constexpr uint64_t IDLE = UINT64_MAX;
+
+  struct alignas(CACHE_LINE_SIZE) Record
+  {
+    std::atomic<uint64_t> epoch{IDLE};
+    std::atomic<bool> in_use{false};
+    Record *next = nullptr;
+    int depth = 0; // nesting of reads, touched only by the owning thread.
+  };
+
+  // The calling thread's record; claimed on its first read and given back
+  // when the thread exits.
+  static Record& local()
+  {
+    thread_local Handle handle;
+    return *handle.record;
+  }
+
+  static uint64_t current_epoch()
+  { return _epoch.load(); }
+
+  // Moves to the next epoch and returns the one that just ended.
+  static uint64_t advance_epoch()
+  { return _epoch.fetch_add(1); }
+
+  // The oldest epoch any thread is reading in, or IDLE if none is reading.
+  static uint64_t oldest_active_epoch()
+  {
+    uint64_t oldest = IDLE;
+    for (Record *r = _records.load(); r != nullptr ; r = r->next)
+    {
+      oldest = std::min(oldest, r->epoch.load());
+    }
+    return oldest;
+  }
+
+ private:
+  struct Handle
+  {
+    Record *record;
+
+    Handle() : record(claim()) {}
+
+    ~Handle()
+    { record->in_use.store(false); }
+  };
+
+  // Records are never freed, only reused, so scanning them is always safe.
+  static Record* claim()
+  {
+    for (Record *r = _records.load(); r != nullptr ; r = r->next)
+    {
+      bool expected = false;
+      if (r->in_use.compare_exchange_strong(expected, true))
+      {
+        return r;
+      }
+    }
+    auto *record = new Record();
+    record->in_use.store(true);
+    record->next = _records.load();
+    while (!_records.compare_exchange_weak(record->next, record)) {}
+    return record;
+  }
+
+  static inline std::atomic<uint64_t> _epoch{0};
+  static inline std::atomic<Record *> _records{nullptr};
+};
+
+// An RCU-style wrapper for maps that are read far more often than written.
+// Readers get wait-free access to an immutable snapshot through an
+// atomically published pointer; writers (serialized by a mutex) copy the
+// current snapshot, modify the copy and publish it. Replaced snapshots are
+// freed by a later write once no reader can still see them; readers never
+// free anything, so they stay wait-free, but a replaced snapshot is retained
+// until the next write (or reclaim()) after its last reader left.
+template <typename MapT>
+class SnapshotMap
+{
+ public:
+  // Keeps the snapshot it was created on alive. Guards may nest on a thread,
+  // but shouldn't be held for long: they hold back reclamation.
+  class ReadGuard
+  {
+   public:
+    ReadGuard(ReadGuard &&other) noexcept
+        : _record(other._record), _snapshot(other._snapshot)
+    { other._record = nullptr; }
+
+    ReadGuard(const ReadGuard &other) = delete;
+
+    ReadGuard& operator=(const ReadGuard &other) = delete;
+
+    ~ReadGuard()
+    {
+      if (_record != nullptr && --_record->depth == 0)
+      {
+        _record->epoch.store(EpochRegistry::IDLE, std::memory_order_release);
+      }
+    }
+
+    const MapT& operator*() const
+    { return *_snapshot; }
+
+    const MapT* operator->() const
+    { return _snapshot; }
+
+   private:
+    friend class SnapshotMap;
+    EpochRegistry::Record *_record;
+    const MapT *_snapshot;
+
+    explicit ReadGuard(const std::atomic<const MapT *> &current)
+        : _record(&EpochRegistry::local())
+    {
+      if (_record->depth++ == 0)
+      {
+        // The announcement must be visible before the pointer is loaded.
+        _record->epoch.store(EpochRegistry::current_epoch());
+      }
+      _snapshot = current.load();
+    }
+  };
+
+  SnapshotMap() : _current(new MapT()) {}
+
+  explicit SnapshotMap(MapT map) : _current(new MapT(std::move(map))) {}
+
+  SnapshotMap(const SnapshotMap &other) = delete;
+
+  SnapshotMap& operator=(const SnapshotMap &other) = delete;
+
+  // There must be no readers left when the SnapshotMap is destroyed.
+  ~SnapshotMap();
+
+  ReadGuard read() const
+  { return ReadGuard(_current); }
+
+  // Publishes a copy of the current snapshot changed by modify(MapT&).
+  // Copying the whole map makes writes expensive; batch them if possible.
+  template <typename F>
+  void modify(F modify);
+
+  // Publishes the given map as the new snapshot.
+  void publish(MapT map);
+
+  template <typename KeyT, typename ValueT>
+  void insert_or_assign(const KeyT &key, const ValueT &value)
+  { modify([&key, &value](MapT &map) { map.insert_or_assign(key, value); }); }
+
+  template <typename KeyT>
+  bool erase(const KeyT &key);
+
+  // Frees the replaced snapshots no reader can see anymore. Writes do this
+  // too; call it when writes are rare and retained snapshots are large.
+  void reclaim();
+
+  int pending_reclamation() const
+  {
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    return (int) _retired.size();
+  }
+
+ private:
+  std::atomic<const MapT *> _current;
+  mutable std::mutex _write_mutex;
+  std::vector<std::pair<const MapT *, uint64_t>> _retired;
+
+  void replace(const MapT *snapshot)
+  {
+    const MapT *old = _current.exchange(snapshot);
+    _retired.emplace_back(old, EpochRegistry::advance_epoch());
+    reclaim_locked();
+  }
+
+  // A snapshot retired in epoch e is unreachable once every active reader
+  // entered in a later epoch: those readers loaded the pointer after it was
+  // replaced.
+  void reclaim_locked()
+  {
+    uint64_t oldest = EpochRegistry::oldest_active_epoch();
+    size_t kept = 0;
+    for (std::pair<const MapT *, uint64_t> &retired : _retired)
+    {
+      if (retired.second < oldest)
+      {
+        delete retired.first;
+      }
+      else
+      {
+        _retired[kept++] = retired;
+      }
+    }
+    _retired.resize(kept);
+  }
+};
+
+template <typename MapT>
+SnapshotMap<MapT>::~SnapshotMap()
+{
+  for (std::pair<const MapT *, uint64_t> &retired : _retired)
+  {
+    delete retired.first;
+  }
+  delete _current.load();
+}
+
+template <typename MapT>
+template <typename F>
+void SnapshotMap<MapT>::modify(F modify)
+{
+  std::lock_guard<std::mutex> lock(_write_mutex);
+  auto *snapshot = new MapT(*_current.load());
+  try
+  {
+    modify(*snapshot);
+  }
+  catch (...)
+  {
+    delete snapshot;
+    throw;
+  }
+  replace(snapshot);
+}
+
+template <typename MapT>
+void SnapshotMap<MapT>::publish(MapT map)
+{
+  auto *snapshot = new MapT(std::move(map));
+  std::lock_guard<std::mutex> lock(_write_mutex);
+  replace(snapshot);
+}
+
+template <typename MapT>
+template <typename KeyT>
+bool SnapshotMap<MapT>::erase(const KeyT &key)
+{
+  std::lock_guard<std::mutex> lock(_write_mutex);
+  if (!_current.load()->contains_key(key))
+  {
+    return false;
+  }
+  auto *snapshot = new MapT(*_current.load());
+  snapshot->erase(key);
+  replace(snapshot);
+  return true;
+}
+
+template <typename MapT>
+void SnapshotMap<MapT>::reclaim()
+{
+  std::lock_guard<std::mutex> lock(_write_mutex);
+  reclaim_locked();
+}
+
+typedef SnapshotMap<Dictionary> SnapshotDictionary;
+
+#endif //_SNAPSHOT_MAP_HPP_
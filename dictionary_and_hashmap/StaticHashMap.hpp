@@ -0,0 +1,204 @@
+#ifndef _STATIC_HASHMAP_HPP_
+#define _STATIC_HASHMAP_HPP_
+
+#include <array>
+#include "HashMap.hpp"
+#define STATIC_SLOTS_PER_KEY 4
+#define STATIC_MULTIPLIERS 256
+#define GOLDEN_RATIO_64 0x9E3779B97F4A7C15ULL
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+#define DUPLICATE_KEY_ERROR "Error: Duplicate key in static map!"
+
+// Hashes that can run at compile time: FNV-1a for strings, mix_hash for
+// integers and enums.
+template <typename KeyT>
+struct StaticHash
+{
+  constexpr size_t operator()(KeyT key) const
+  { return mix_hash((uint64_t) key); }
+};
+
+template <>
+struct StaticHash<std::string_view>
+{
+  constexpr size_t operator()(std::string_view key) const
+  {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (char c : key)
+    {
+      hash ^= (unsigned char) c;
+      hash *= FNV_PRIME;
+    }
+    return (size_t) hash;
+  }
+};
+
+// Log2 of the smallest power of two, 2 or more, with STATIC_SLOTS_PER_KEY
+// slots per key.
+constexpr int static_capacity_bits(size_t n)
+{
+  int bits = 1;
+  while (((size_t) 1 << bits) < STATIC_SLOTS_PER_KEY * n)
+  {
+    bits++;
+  }
+  return bits;
+}
+
+// A map of N pairs fixed at compile time, e.g. status codes or command names:
+//   constexpr auto codes = make_static_map<std::string_view, int>(
+//       {{"get", 1}, {"set", 2}});
+// The pairs are laid out by linear probing in a table of at least
+// STATIC_SLOTS_PER_KEY slots per key. A key's home slot is the top bits of
+// its hash times a multiplier; the constructor lays the table out with
+// STATIC_MULTIPLIERS of them and keeps the one with the shortest longest
+// probe sequence, for small tables often a single slot. All of this is
+// constexpr, so a constexpr map is built by the compiler and a lookup with a
+// constant key folds to its value. Otherwise a lookup hashes the key,
+// multiplies, and compares keys in at most max_probe() slots.
+// Keys and values must be literal types that can be default constructed;
+// string keys are std::string_view, which a std::string converts to. A
+// duplicate key fails to compile.
+template <typename KeyT, typename ValueT, size_t N,
+          typename Hash = StaticHash<KeyT>>
+class StaticHashMap
+{
+ public:
+  typedef std::pair<KeyT, ValueT> PairT;
+
+  static constexpr int CAPACITY_BITS = static_capacity_bits(N);
+  static constexpr size_t CAPACITY = (size_t) 1 << CAPACITY_BITS;
+
+  constexpr explicit StaticHashMap(const PairT (&pairs)[N]);
+
+  constexpr bool contains_key(const KeyT &key) const
+  { return find(key) != N; }
+
+  constexpr const ValueT& at(const KeyT &key) const
+  {
+    size_t index = find(key);
+    if (index == N)
+    {
+      throw std::out_of_range(KEY_ERROR);
+    }
+    return _pairs[index].second;
+  }
+
+  constexpr int size() const
+  { return (int) N;}
+
+  constexpr bool empty() const
+  { return N == 0;}
+
+  // The most slots a lookup reads.
+  constexpr int max_probe() const
+  { return _max_probe + 1;}
+
+  // In the order the pairs were given.
+  constexpr const PairT* begin() const
+  { return _pairs.data(); }
+
+  constexpr const PairT* end() const
+  { return _pairs.data() + N; }
+
+ private:
+  Hash _hasher;
+  uint64_t _multiplier = 0; // odd.
+  std::array<PairT, N> _pairs{};
+  std::array<uint32_t, CAPACITY> _slots{}; // index in _pairs + 1, 0 if free.
+  int _max_probe = 0; // the longest distance of a pair from its home slot.
+
+  constexpr size_t home_slot(uint64_t hash) const
+  { return (size_t) ((hash * _multiplier) >> (64 - CAPACITY_BITS)); }
+
+  // Lays the pairs out for the current multiplier; returns _max_probe.
+  constexpr int place(const std::array<uint64_t, N> &hashes);
+
+  // The key's index in _pairs, or N if the key is missing.
+  constexpr size_t find(const KeyT &key) const
+  {
+    size_t slot = home_slot(_hasher(key));
+    for (int probe = 0 ; probe <= _max_probe ; probe++)
+    {
+      uint32_t index = _slots[slot];
+      if (index == 0)
+      {
+        return N;
+      }
+      if (_pairs[index - 1].first == key)
+      {
+        return index - 1;
+      }
+      slot = (slot + 1) & (CAPACITY - 1);
+    }
+    return N;
+  }
+};
+
+template <typename KeyT, typename ValueT, size_t N, typename Hash>
+constexpr StaticHashMap<KeyT, ValueT, N, Hash>::StaticHashMap
+(const PairT (&pairs)[N])
+{
+  std::array<uint64_t, N> hashes{};
+  for (size_t i = 0 ; i < N ; i++)
+  {
+    // Members are assigned one by one: std::pair's assignment isn't
+    // constexpr before C++20.
+    _pairs[i].first = pairs[i].first;
+    _pairs[i].second = pairs[i].second;
+    hashes[i] = _hasher(pairs[i].first);
+  }
+  uint64_t best_multiplier = GOLDEN_RATIO_64;
+  int best_probe = (int) CAPACITY;
+  for (uint64_t i = 0 ; i < STATIC_MULTIPLIERS && best_probe > 0 ; i++)
+  {
+    _multiplier = GOLDEN_RATIO_64 * (2 * i + 1);
+    int probe = place(hashes);
+    if (probe < best_probe)
+    {
+      best_probe = probe;
+      best_multiplier = _multiplier;
+    }
+  }
+  _multiplier = best_multiplier;
+  place(hashes);
+}
+
+template <typename KeyT, typename ValueT, size_t N, typename Hash>
+constexpr int
+StaticHashMap<KeyT, ValueT, N, Hash>::place
+(const std::array<uint64_t, N> &hashes)
+{
+  for (size_t slot = 0 ; slot < CAPACITY ; slot++)
+  {
+    _slots[slot] = 0;
+  }
+  _max_probe = 0;
+  for (size_t i = 0 ; i < N ; i++)
+  {
+    size_t slot = home_slot(hashes[i]);
+    int probe = 0;
+    for ( ; _slots[slot] != 0 ; probe++)
+    {
+      if (_pairs[_slots[slot] - 1].first == _pairs[i].first)
+      {
+        throw std::invalid_argument(DUPLICATE_KEY_ERROR);
+      }
+      slot = (slot + 1) & (CAPACITY - 1);
+    }
+    _slots[slot] = (uint32_t) i + 1;
+    _max_probe = std::max(_max_probe, probe);
+  }
+  return _max_probe;
+}
+
+// Deduces N from the braced list of pairs, which a constructor can't.
+template <typename KeyT, typename ValueT, size_t N>
+constexpr StaticHashMap<KeyT, ValueT, N>
+make_static_map(const std::pair<KeyT, ValueT> (&pairs)[N])
+{
+  return StaticHashMap<KeyT, ValueT, N>(pairs);
+}
+
+#endif //_STATIC_HASHMAP_HPP_
@@ -0,0 +1,76 @@
+#ifndef _BENCH_UTILS_HPP_
+#define _BENCH_UTILS_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Shared helpers of the HashMap benchmarks. Every benchmark is a standalone
+// program, built from the dictionary_and_hashmap directory with e.g.
+//   g++ -std=c++17 -O2 -I. benchmarks/<name>.cpp -o bench && ./bench [N]
+
+class Timer
+{
+ public:
+  Timer() : _start(std::chrono::steady_clock::now()) {}
+
+  double elapsed_ms() const
+  {
+    return std::chrono::duration<double, std::milli>
+        (std::chrono::steady_clock::now() - _start).count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point _start;
+};
+
+// Keeps the compiler from optimizing away a computed value.
+template <typename T>
+inline void do_not_optimize(const T &value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline size_t arg_or_default(int argc, char **argv, size_t def)
+{
+  return argc > 1 ? std::strtoul(argv[1], nullptr, 10) : def;
+}
+
+// Random alphanumeric keys of the given length.
+inline std::vector<std::string> random_keys(size_t n, size_t len,
+                                            unsigned seed = 42)
+{
+  static const char alphabet[] =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> pick(0, sizeof(alphabet) - 2);
+  std::vector<std::string> keys(n);
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    keys[i].resize(len);
+    for (char &c : keys[i])
+    {
+      c = alphabet[pick(rng)];
+    }
+  }
+  return keys;
+}
+
+inline void report(const std::string &name, double ms, size_t ops)
+{
+  std::cout << name << ": " << ms << " ms, " << (ms * 1e6 / ops)
+            << " ns/op" << std::endl;
+}
+
+// The q-th quantile (0 <= q <= 1) of the samples; sorts them in place.
+inline double percentile(std::vector<double> &samples, double q)
+{
+  std::sort(samples.begin(), samples.end());
+  return samples[(size_t) (q * (samples.size() - 1))];
+}
+
+#endif //_BENCH_UTILS_HPP_
@@ -0,0 +1,80 @@
+// Bucket-length distribution and throughput for sequential, strided and
+// high-bit integer keys, with the raw std::hash (the identity) against the
+// default mixing hasher.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+#include <map>
+#include <set>
+
+template <typename Hash>
+void measure(const std::string &name, const std::vector<long> &keys)
+{
+  Timer insert_timer;
+  HashMap<long, long, Hash> map;
+  for (long key : keys)
+  {
+    map.insert(key, key);
+  }
+  double insert_ms = insert_timer.elapsed_ms();
+
+  long sum = 0;
+  Timer lookup_timer;
+  for (long key : keys)
+  {
+    sum += map.at(key);
+  }
+  double lookup_ms = lookup_timer.elapsed_ms();
+  do_not_optimize(sum);
+
+  // Bucket length -> number of buckets of that length.
+  std::map<int, int> histogram;
+  std::set<int> seen; // during a migration, indices go past capacity().
+  int longest = 0;
+  for (long key : keys)
+  {
+    int index = map.bucket_index(key);
+    if (seen.insert(index).second)
+    {
+      histogram[map.bucket_size(key)]++;
+      longest = std::max(longest, map.bucket_size(key));
+    }
+  }
+  std::cout << "  " << name << ": insert " << insert_ms * 1e6 / keys.size()
+            << " ns, lookup " << lookup_ms * 1e6 / keys.size()
+            << " ns, longest bucket " << longest << ", lengths {";
+  int shown = 0;
+  for (const std::pair<const int, int> &entry : histogram)
+  {
+    if (shown++ == 6)
+    {
+      std::cout << " ...";
+      break;
+    }
+    std::cout << " " << entry.first << ":" << entry.second;
+  }
+  std::cout << " }" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  // High-bit keys all share bucket 0 under the identity hash, which makes
+  // that case quadratic; keep n moderate.
+  long n = (long) arg_or_default(argc, argv, 20000);
+  std::vector<std::pair<std::string, long>> patterns = {
+      {"sequential", 1},
+      {"strided by 1024", 1024},
+      {"high bits (i << 32)", 1L << 32}};
+  for (const std::pair<std::string, long> &pattern : patterns)
+  {
+    std::vector<long> keys(n);
+    for (long i = 0 ; i < n ; i++)
+    {
+      keys[i] = i * pattern.second;
+    }
+    std::cout << pattern.first << " keys:" << std::endl;
+    measure<std::hash<long>>("std::hash", keys);
+    measure<HashMapHash<long>>("HashMapHash", keys);
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+// Heap bytes per entry of Dictionary against ArenaDictionary, with and
+// without value interning, on a corpus of profile-like records: keys such
+// as "user:123456:country" and values drawn from small sets (countries,
+// statuses) or unique (emails, timestamps).
+
+#include "../ArenaDictionary.hpp"
+#include "BenchUtils.hpp"
+#include <malloc.h>
+#include <new>
+
+static size_t heap_bytes = 0;
+
+void *operator new(size_t size)
+{
+  void *p = std::malloc(size);
+  if (p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  heap_bytes += malloc_usable_size(p);
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  if (p != nullptr)
+  {
+    heap_bytes -= malloc_usable_size(p);
+    std::free(p);
+  }
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+std::vector<std::pair<std::string, std::string>> corpus(size_t users,
+                                                        bool unique_fields)
+{
+  static const char *countries[] = {"Israel", "France", "Germany", "Brazil",
+                                    "Japan", "Canada", "India", "Kenya"};
+  static const char *statuses[] = {"active", "suspended", "pending"};
+  std::mt19937 rng(5);
+  std::vector<std::pair<std::string, std::string>> records;
+  for (size_t u = 0 ; u < users ; u++)
+  {
+    std::string prefix = "user:" + std::to_string(100000 + u) + ":";
+    records.emplace_back(prefix + "country", countries[rng() % 8]);
+    records.emplace_back(prefix + "status", statuses[rng() % 3]);
+    if (!unique_fields)
+    {
+      continue;
+    }
+    records.emplace_back(prefix + "email", "person" + std::to_string(rng()) +
+                                           "@example.com");
+    records.emplace_back(prefix + "created", std::to_string(1600000000 +
+                                                            rng() % 100000000));
+  }
+  return records;
+}
+
+template <typename Map>
+void measure(const std::string &name, Map &map,
+             const std::vector<std::pair<std::string, std::string>> &records)
+{
+  size_t before = heap_bytes;
+  Timer timer;
+  for (const std::pair<std::string, std::string> &record : records)
+  {
+    map.insert(record.first, record.second);
+  }
+  double ms = timer.elapsed_ms();
+  std::cout << name << ": " << (double) (heap_bytes - before) / records.size()
+            << " bytes per entry, " << ms * 1e6 / records.size()
+            << " ns per insert" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  size_t users = arg_or_default(argc, argv, 250000);
+  for (bool unique_fields : {true, false})
+  {
+    std::vector<std::pair<std::string, std::string>> records =
+        corpus(users, unique_fields);
+    size_t payload = 0;
+    for (const std::pair<std::string, std::string> &record : records)
+    {
+      payload += record.first.size() + record.second.size();
+    }
+    std::cout << (unique_fields ? "all fields: " : "repeated values only: ")
+              << records.size() << " entries, " << (double) payload /
+              records.size() << " bytes of key and value per entry"
+              << std::endl;
+    {
+      Dictionary dict;
+      measure("  Dictionary", dict, records);
+    }
+    {
+      ArenaDictionary arena;
+      measure("  ArenaDictionary", arena, records);
+    }
+    {
+      ArenaDictionary interned(true);
+      measure("  ArenaDictionary, interned values", interned, records);
+    }
+  }
+  return 0;
+}
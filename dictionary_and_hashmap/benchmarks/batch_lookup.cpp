@@ -0,0 +1,54 @@
+// Lookups of random keys, in requests of 32 keys, one by one with at() and
+// batched with find_many(). The default table (about 650 MB with its
+// entries) is meant to be larger than the last level cache; pass a larger N
+// on machines with a bigger one.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+
+#define KEYS_PER_REQUEST 32
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 8000000);
+  HashMap<long, long> map;
+  map.reserve((int) n);
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    map.insert((long) i, (long) i);
+  }
+  std::mt19937_64 rng(7);
+  std::vector<long> keys(4000000);
+  for (long &key : keys)
+  {
+    key = (long) (rng() % n);
+  }
+
+  long sum = 0;
+  Timer single_timer;
+  for (size_t i = 0 ; i < keys.size() ; i++)
+  {
+    sum += map.at(keys[i]);
+  }
+  double single_ms = single_timer.elapsed_ms();
+
+  const long *values[KEYS_PER_REQUEST];
+  Timer batch_timer;
+  for (size_t i = 0 ; i < keys.size() ; i += KEYS_PER_REQUEST)
+  {
+    map.find_many(keys.begin() + i, keys.begin() + i + KEYS_PER_REQUEST,
+                  values);
+    for (const long *value : values)
+    {
+      sum += *value;
+    }
+  }
+  double batch_ms = batch_timer.elapsed_ms();
+  do_not_optimize(sum);
+
+  std::cout << "at: " << single_ms * 1e6 / keys.size() << " ns per key"
+            << std::endl;
+  std::cout << "find_many: " << batch_ms * 1e6 / keys.size()
+            << " ns per key" << std::endl;
+  return 0;
+}
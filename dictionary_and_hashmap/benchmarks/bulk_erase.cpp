@@ -0,0 +1,58 @@
+// Expiring 90% of a map of N entries: erasing the expired keys one by one,
+// which may shrink the table several times on the way down, against
+// erase(first, last) over the same keys and erase_if on the values, which
+// resize once at the end.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+
+// The values are insertion times; every key older than the cutoff expires.
+HashMap<long, long> build(size_t n)
+{
+  HashMap<long, long> map;
+  map.set_stats_enabled(true);
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    map.insert((long) (i * 2654435761u), (long) i);
+  }
+  map.reset_stats();
+  return map;
+}
+
+void report_expiry(const std::string &name, HashMap<long, long> &map,
+                   double ms)
+{
+  std::cout << name << ": " << ms << " ms, " << map.stats().rehashes
+            << " rehashes, " << map.size() << " left" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 4000000);
+  long cutoff = (long) (n * 9 / 10);
+  std::vector<long> expired;
+  for (size_t i = 0 ; i < (size_t) cutoff ; i++)
+  {
+    expired.push_back((long) (i * 2654435761u));
+  }
+
+  HashMap<long, long> one_by_one = build(n);
+  Timer erase_timer;
+  for (long key : expired)
+  {
+    one_by_one.erase(key);
+  }
+  report_expiry("erase each key", one_by_one, erase_timer.elapsed_ms());
+
+  HashMap<long, long> by_range = build(n);
+  Timer range_timer;
+  by_range.erase(expired.begin(), expired.end());
+  report_expiry("erase(first, last)", by_range, range_timer.elapsed_ms());
+
+  HashMap<long, long> by_predicate = build(n);
+  Timer predicate_timer;
+  by_predicate.erase_if([cutoff](const std::pair<long, long> &pair)
+                        { return pair.second < cutoff; });
+  report_expiry("erase_if", by_predicate, predicate_timer.elapsed_ms());
+  return 0;
+}
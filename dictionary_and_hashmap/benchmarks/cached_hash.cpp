@@ -0,0 +1,86 @@
+// Rehash time and lookup cost for long string keys, with and without hash
+// codes cached in the entries. The two key types differ only in
+// cache_hash_code. Keys share a long prefix, so comparisons are costly.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+
+template <bool Cached>
+struct LongKey
+{
+  std::string text;
+
+  bool operator==(const LongKey &other) const
+  { return text == other.text; }
+};
+
+template <bool Cached>
+struct std::hash<LongKey<Cached>>
+{
+  size_t operator()(const LongKey<Cached> &key) const
+  { return std::hash<std::string>{}(key.text); }
+};
+
+template <>
+struct cache_hash_code<LongKey<true>> : std::true_type {};
+
+template <bool Cached>
+void measure(const std::string &name, const std::vector<std::string> &texts)
+{
+  HashMap<LongKey<Cached>, int> map;
+  std::vector<LongKey<Cached>> keys;
+  for (const std::string &text : texts)
+  {
+    keys.push_back({text});
+  }
+  for (size_t i = 0 ; i < keys.size() ; i++)
+  {
+    map.insert(keys[i], (int) i);
+  }
+
+  // Growing then shrinking a full table rehashes every key twice.
+  Timer rehash_timer;
+  map.reserve(4 * map.capacity());
+  map.reserve(0);
+  map.set_load_factors(0.5, 1.5);
+  double rehash_ms = rehash_timer.elapsed_ms();
+
+  long sum = 0;
+  Timer hit_timer;
+  for (const LongKey<Cached> &key : keys)
+  {
+    sum += map.at(key);
+  }
+  double hit_ms = hit_timer.elapsed_ms();
+
+  // Misses with the same long prefix: every entry of the bucket is compared.
+  std::vector<LongKey<Cached>> misses;
+  for (const LongKey<Cached> &key : keys)
+  {
+    misses.push_back({key.text + "!"});
+  }
+  Timer miss_timer;
+  for (const LongKey<Cached> &key : misses)
+  {
+    sum += map.contains_key(key);
+  }
+  double miss_ms = miss_timer.elapsed_ms();
+  do_not_optimize(sum);
+  std::cout << name << ": rehash " << rehash_ms << " ms, hit "
+            << hit_ms * 1e6 / keys.size() << " ns, miss "
+            << miss_ms * 1e6 / keys.size() << " ns" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 500000);
+  std::vector<std::string> texts = random_keys(n, 32);
+  std::string prefix(200, '/');
+  for (std::string &text : texts)
+  {
+    text = prefix + text;
+  }
+  measure<false>("recomputed hashes", texts);
+  measure<true>("cached hashes", texts);
+  return 0;
+}
@@ -0,0 +1,109 @@
+// Throughput of a HashMap behind one global mutex against ConcurrentHashMap,
+// for 1 to all hardware threads, under read-heavy and write-heavy mixes.
+// Build with -pthread.
+
+#include "../ConcurrentHashMap.hpp"
+#include "BenchUtils.hpp"
+#include <thread>
+
+class GlobalLockMap
+{
+ public:
+  bool insert_or_assign(int key, int value)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _map.insert_or_assign(key, value);
+  }
+
+  bool find(int key, int &out) const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_map.contains_key(key))
+    {
+      return false;
+    }
+    out = _map.at(key);
+    return true;
+  }
+
+  bool erase(int key)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _map.erase(key);
+  }
+
+ private:
+  mutable std::mutex _mutex;
+  HashMap<int, int> _map;
+};
+
+const int KEY_RANGE = 1 << 16;
+const int OPS_PER_THREAD = 1 << 20;
+
+// Runs write_percent% writes (half inserts, half erases), the rest reads.
+template <typename Map>
+double run(Map &map, int threads, int write_percent)
+{
+  for (int i = 0 ; i < KEY_RANGE ; i += 2)
+  {
+    map.insert_or_assign(i, i);
+  }
+  std::vector<std::thread> workers;
+  Timer timer;
+  for (int t = 0 ; t < threads ; t++)
+  {
+    workers.emplace_back([&map, t, write_percent] {
+      std::mt19937 rng(t);
+      int found = 0, value;
+      for (int i = 0 ; i < OPS_PER_THREAD ; i++)
+      {
+        unsigned r = rng();
+        int key = (int) (r % KEY_RANGE);
+        if ((int) ((r >> 20) % 100) >= write_percent)
+        {
+          found += map.find(key, value);
+        }
+        else if (r & (1u << 31))
+        {
+          map.insert_or_assign(key, i);
+        }
+        else
+        {
+          map.erase(key);
+        }
+      }
+      do_not_optimize(found);
+    });
+  }
+  for (std::thread &worker : workers)
+  {
+    worker.join();
+  }
+  double seconds = timer.elapsed_ms() / 1000;
+  return threads * (double) OPS_PER_THREAD / seconds / 1e6;
+}
+
+int main()
+{
+  int max_threads = (int) std::max(1u, std::thread::hardware_concurrency());
+  std::vector<int> thread_counts;
+  for (int threads = 1 ; threads < max_threads ; threads *= 2)
+  {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+  for (int write_percent : {10, 50})
+  {
+    std::cout << write_percent << "% writes (Mops/s):" << std::endl;
+    for (int threads : thread_counts)
+    {
+      GlobalLockMap global;
+      ConcurrentHashMap<int, int> sharded(4 * max_threads);
+      double global_mops = run(global, threads, write_percent);
+      double sharded_mops = run(sharded, threads, write_percent);
+      std::cout << "  " << threads << " threads: global mutex "
+                << global_mops << ", sharded " << sharded_mops << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,53 @@
+// Copy-then-read: each round copies a map of N string keys and reads a
+// thousand keys from the copy, as a request handler working on its own copy
+// of shared configuration would. Copies share the source's tables (reads go
+// through a const copy, since a non-const at() would copy them); the eager
+// rounds copy a source that handed out a non-const reference, which forces
+// a deep copy. The last line is the cost of the first write to a shared copy.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+
+const size_t ROUNDS = 20, READS = 1000;
+
+void copy_then_read(const std::string &name,
+                    const HashMap<std::string, int> &map,
+                    const std::vector<std::string> &keys)
+{
+  long sum = 0;
+  Timer timer;
+  for (size_t round = 0 ; round < ROUNDS ; round++)
+  {
+    const HashMap<std::string, int> copy = map;
+    for (size_t i = 0 ; i < READS ; i++)
+    {
+      sum += copy.at(keys[(round * READS + i) % keys.size()]);
+    }
+  }
+  do_not_optimize(sum);
+  std::cout << name << ": " << timer.elapsed_ms() / ROUNDS
+            << " ms per copy and " << READS << " reads" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 1000000);
+  std::vector<std::string> keys = random_keys(n, 16);
+  HashMap<std::string, int> map;
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    map.insert(keys[i], (int) i);
+  }
+  copy_then_read("shared", map, keys);
+
+  HashMap<std::string, int> written = map;
+  Timer timer;
+  written.insert("new key", 0);
+  double write_ms = timer.elapsed_ms();
+
+  map.at(keys[0]) = 0; // a non-const reference: copies are deep from now on.
+  copy_then_read("eager", map, keys);
+  std::cout << "first write to a shared copy: " << write_ms << " ms"
+            << std::endl;
+  return 0;
+}
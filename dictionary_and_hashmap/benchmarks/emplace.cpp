@@ -0,0 +1,61 @@
+// String-heavy loads: word counting through operator[], and filling a
+// Dictionary with copied pairs, moved pairs and try_emplace.
+
+#include "../Dictionary.hpp"
+#include "BenchUtils.hpp"
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 200000);
+  std::vector<std::string> keys = random_keys(n, 32);
+  std::vector<std::string> values = random_keys(n, 64, 7);
+
+  std::vector<std::string> words = random_keys(n / 4, 8, 3);
+  HashMap<std::string, int> counts;
+  Timer count_timer;
+  for (int r = 0 ; r < 8 ; r++)
+  {
+    for (const std::string &word : words)
+    {
+      counts[word]++;
+    }
+  }
+  report("operator[] word count", count_timer.elapsed_ms(), 8 * words.size());
+
+  Dictionary copied;
+  Timer copy_timer;
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    copied.insert(keys[i], values[i]);
+  }
+  report("insert(const KeyT&, const ValueT&)", copy_timer.elapsed_ms(), n);
+
+  std::vector<std::string> moved_keys = keys, moved_values = values;
+  Dictionary moved;
+  Timer move_timer;
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    moved.insert(std::move(moved_keys[i]), std::move(moved_values[i]));
+  }
+  report("insert(KeyT&&, ValueT&&)", move_timer.elapsed_ms(), n);
+
+  Dictionary emplaced;
+  Timer emplace_timer;
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    emplaced.try_emplace(keys[i], 64, 'v');
+  }
+  report("try_emplace(key, count, char)", emplace_timer.elapsed_ms(), n);
+
+  std::vector<std::pair<std::string, std::string>> updates;
+  for (size_t i = 0 ; i < n ; i += 2)
+  {
+    updates.emplace_back(keys[i], values[n - 1 - i]);
+  }
+  Timer update_timer;
+  copied.update(updates.begin(), updates.end());
+  report("Dictionary::update (assign)", update_timer.elapsed_ms(),
+         updates.size());
+  do_not_optimize(counts.size() + moved.size() + emplaced.size());
+  return 0;
+}
@@ -0,0 +1,61 @@
+// Build time, index size and lookup cost of a FrozenDictionary against the
+// Dictionary it is built from, for hits and misses.
+
+#include "../FrozenHashMap.hpp"
+#include "BenchUtils.hpp"
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 1000000);
+  std::vector<std::string> keys = random_keys(n, 16);
+  std::vector<std::string> misses = random_keys(n, 16, 99);
+  Dictionary dict;
+  for (const std::string &key : keys)
+  {
+    dict.insert(key, key);
+  }
+
+  Timer build_timer;
+  FrozenDictionary frozen(dict);
+  double build_ms = build_timer.elapsed_ms();
+  std::cout << "build " << build_ms << " ms, "
+            << (double) frozen.index_bits() / n << " index bits per key"
+            << std::endl;
+
+  // Look up in another order than insertion, so that the Dictionary's
+  // entries aren't walked in allocation order.
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+  size_t sum = 0;
+  Timer dict_hit_timer;
+  for (const std::string &key : keys)
+  {
+    sum += dict.at(key).size();
+  }
+  double dict_hit_ms = dict_hit_timer.elapsed_ms();
+  Timer frozen_hit_timer;
+  for (const std::string &key : keys)
+  {
+    sum += frozen.at(key).size();
+  }
+  double frozen_hit_ms = frozen_hit_timer.elapsed_ms();
+
+  Timer dict_miss_timer;
+  for (const std::string &key : misses)
+  {
+    sum += dict.contains_key(key);
+  }
+  double dict_miss_ms = dict_miss_timer.elapsed_ms();
+  Timer frozen_miss_timer;
+  for (const std::string &key : misses)
+  {
+    sum += frozen.contains_key(key);
+  }
+  double frozen_miss_ms = frozen_miss_timer.elapsed_ms();
+  do_not_optimize(sum);
+
+  std::cout << "Dictionary: hit " << dict_hit_ms * 1e6 / n << " ns, miss "
+            << dict_miss_ms * 1e6 / n << " ns" << std::endl;
+  std::cout << "FrozenDictionary: hit " << frozen_hit_ms * 1e6 / n
+            << " ns, miss " << frozen_miss_ms * 1e6 / n << " ns" << std::endl;
+  return 0;
+}
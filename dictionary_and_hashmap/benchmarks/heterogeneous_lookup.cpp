@@ -0,0 +1,57 @@
+// Lookups of Dictionary keys from a std::string_view token stream: the
+// tokens are either copied into a std::string for every lookup (what callers
+// had to do before) or passed to the transparent overloads as they are.
+
+#include "../Dictionary.hpp"
+#include "BenchUtils.hpp"
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 100000);
+  std::vector<std::string> keys = random_keys(n, 24);
+  Dictionary dict;
+  std::string text;
+  for (const std::string &key : keys)
+  {
+    dict.insert(key, key);
+    text += key;
+    text += ' ';
+  }
+
+  std::vector<std::string_view> tokens;
+  std::string_view rest(text);
+  for (size_t pos = rest.find(' '); pos != std::string_view::npos;
+       pos = rest.find(' '))
+  {
+    tokens.push_back(rest.substr(0, pos));
+    rest.remove_prefix(pos + 1);
+  }
+
+  const int rounds = 10;
+  size_t found = 0;
+  Timer copy_timer;
+  for (int r = 0 ; r < rounds ; r++)
+  {
+    for (std::string_view token : tokens)
+    {
+      found += dict.contains_key(std::string(token));
+      do_not_optimize(dict.at(std::string(token)));
+    }
+  }
+  report("std::string temporaries", copy_timer.elapsed_ms(),
+         2 * rounds * tokens.size());
+
+  Timer view_timer;
+  for (int r = 0 ; r < rounds ; r++)
+  {
+    for (std::string_view token : tokens)
+    {
+      found += dict.contains_key(token);
+      do_not_optimize(dict.at(token));
+    }
+  }
+  report("std::string_view lookups", view_timer.elapsed_ms(),
+         2 * rounds * tokens.size());
+  do_not_optimize(found);
+  return 0;
+}
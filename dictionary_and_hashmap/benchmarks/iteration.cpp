@@ -0,0 +1,36 @@
+// Full-map iteration over maps of the same table size at varying load
+// factors; empty buckets are skipped a bitmap word at a time.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+
+int main(int argc, char **argv)
+{
+  int capacity_entries = (int) arg_or_default(argc, argv, 1 << 20);
+  for (double load : {0.001, 0.01, 0.1, 0.25, 0.5, 0.75})
+  {
+    HashMap<int, int> map;
+    map.reserve(capacity_entries);
+    int n = (int) (load * map.capacity());
+    for (int i = 0 ; i < n ; i++)
+    {
+      map.insert(i * 7, i);
+    }
+    const int rounds = 20;
+    long sum = 0;
+    Timer timer;
+    for (int r = 0 ; r < rounds ; r++)
+    {
+      for (const auto &pair : map)
+      {
+        sum += pair.second;
+      }
+    }
+    double ms = timer.elapsed_ms() / rounds;
+    std::cout << "load " << map.get_load_factor() << " (" << n << " of "
+              << map.capacity() << " buckets): " << ms << " ms per pass, "
+              << (n ? ms * 1e6 / n : 0) << " ns per entry" << std::endl;
+    do_not_optimize(sum);
+  }
+  return 0;
+}
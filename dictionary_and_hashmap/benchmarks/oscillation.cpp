@@ -0,0 +1,89 @@
+// Insert/erase workloads that hover around a resize boundary. A rehash
+// always changes capacity(), so rehashes are counted by watching it.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+
+struct Counter
+{
+  int last_capacity;
+  long rehashes = 0;
+
+  explicit Counter(const HashMap<int, int> &map)
+      : last_capacity(map.capacity()) {}
+
+  void check(const HashMap<int, int> &map)
+  {
+    if (map.capacity() != last_capacity)
+    {
+      rehashes++;
+      last_capacity = map.capacity();
+    }
+  }
+};
+
+// Alternates inserting and erasing a batch of keys on top of base entries.
+void oscillate(const std::string &name, HashMap<int, int> &map, int base,
+               int batch, int rounds)
+{
+  for (int i = 0 ; i < base ; i++)
+  {
+    map.insert(i, i);
+  }
+  Counter counter(map);
+  Timer timer;
+  for (int r = 0 ; r < rounds ; r++)
+  {
+    for (int i = base ; i < base + batch ; i++)
+    {
+      map.insert(i, i);
+      counter.check(map);
+    }
+    for (int i = base ; i < base + batch ; i++)
+    {
+      map.erase(i);
+      counter.check(map);
+    }
+  }
+  double ms = timer.elapsed_ms();
+  std::cout << name << ": " << counter.rehashes << " rehashes, " << ms
+            << " ms" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  int rounds = (int) arg_or_default(argc, argv, 100000);
+
+  HashMap<int, int> empty;
+  oscillate("single entry on an empty map", empty, 0, 1, rounds);
+
+  HashMap<int, int> grow_boundary;
+  oscillate("around the growth boundary (12 of 16)", grow_boundary, 12, 1,
+            rounds);
+
+  HashMap<int, int> drain;
+  oscillate("refilling a drained map", drain, 0, 64, rounds / 64);
+
+  HashMap<int, int> reserved;
+  reserved.reserve(64);
+  oscillate("refilling a drained map after reserve(64)", reserved, 0, 64,
+            rounds / 64);
+
+  std::vector<int> keys(1 << 20), values(1 << 20);
+  for (int i = 0 ; i < (int) keys.size() ; i++)
+  {
+    keys[i] = values[i] = i;
+  }
+  Timer incremental_timer;
+  HashMap<int, int> incremental;
+  for (int i = 0 ; i < (int) keys.size() ; i++)
+  {
+    incremental.insert(keys[i], values[i]);
+  }
+  report("one insert at a time", incremental_timer.elapsed_ms(), keys.size());
+  Timer bulk_timer;
+  HashMap<int, int> bulk(keys, values);
+  report("bulk-load constructor", bulk_timer.elapsed_ms(), keys.size());
+  do_not_optimize(incremental.size() + bulk.size());
+  return 0;
+}
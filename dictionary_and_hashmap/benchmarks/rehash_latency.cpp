@@ -0,0 +1,35 @@
+// Per-insert latency while a map grows to N entries, with the whole-table
+// rehash and with incremental rehashing. The tail shows the resizes.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+
+void measure(const std::string &name, bool incremental, size_t n)
+{
+  HashMap<long, long> map;
+  map.set_incremental_rehash(incremental);
+  std::vector<double> latencies(n);
+  Timer total;
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    map.insert((long) i, (long) i);
+    latencies[i] = std::chrono::duration<double, std::micro>
+        (std::chrono::steady_clock::now() - start).count();
+  }
+  double ms = total.elapsed_ms();
+  double max = *std::max_element(latencies.begin(), latencies.end());
+  std::cout << name << ": total " << ms << " ms, p50 "
+            << percentile(latencies, 0.5) << " us, p99 "
+            << percentile(latencies, 0.99) << " us, p99.9 "
+            << percentile(latencies, 0.999) << " us, max " << max << " us"
+            << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 4000000);
+  measure("whole-table rehash", false, n);
+  measure("incremental rehash", true, n);
+  return 0;
+}
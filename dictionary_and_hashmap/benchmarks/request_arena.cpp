@@ -0,0 +1,80 @@
+// Per-request maps: each request builds a map of 256 entries, looks them all
+// up and throws the map away. The default allocator is compared with a
+// pmr::HashMap in a monotonic arena that is released after every request,
+// either destroying the map first or just releasing the arena (valid here
+// because the keys and values own no memory of their own).
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+#include <memory_resource>
+
+#define ENTRIES_PER_REQUEST 256
+
+template <typename MapT>
+long serve(MapT &map)
+{
+  for (long k = 0 ; k < ENTRIES_PER_REQUEST ; k++)
+  {
+    map.insert(k * 7919, k);
+  }
+  long sum = 0;
+  for (long k = 0 ; k < ENTRIES_PER_REQUEST ; k++)
+  {
+    sum += map.at(k * 7919);
+  }
+  return sum;
+}
+
+void report_requests(const std::string &name, double build_ms,
+                     double teardown_ms, size_t requests)
+{
+  std::cout << name << ": " << build_ms * 1e6 / requests
+            << " ns per request, teardown "
+            << teardown_ms * 1e6 / requests << " ns" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  size_t requests = arg_or_default(argc, argv, 20000);
+  long sum = 0;
+  double build_ms = 0, teardown_ms = 0;
+  for (size_t r = 0 ; r < requests ; r++)
+  {
+    Timer build_timer;
+    HashMap<long, long> *map = new HashMap<long, long>();
+    sum += serve(*map);
+    build_ms += build_timer.elapsed_ms();
+    Timer teardown_timer;
+    delete map;
+    teardown_ms += teardown_timer.elapsed_ms();
+  }
+  report_requests("default allocator", build_ms, teardown_ms, requests);
+
+  std::vector<char> buffer(1 << 20);
+  for (bool destroy : {true, false})
+  {
+    build_ms = teardown_ms = 0;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    for (size_t r = 0 ; r < requests ; r++)
+    {
+      Timer build_timer;
+      std::pmr::polymorphic_allocator<pmr::HashMap<long, long>> allocator
+          (&arena);
+      pmr::HashMap<long, long> *map = allocator.allocate(1);
+      new (map) pmr::HashMap<long, long>(&arena);
+      sum += serve(*map);
+      build_ms += build_timer.elapsed_ms();
+      Timer teardown_timer;
+      if (destroy)
+      {
+        map->~HashMap();
+      }
+      arena.release();
+      teardown_ms += teardown_timer.elapsed_ms();
+    }
+    report_requests(destroy ? "arena, destroyed" : "arena, released only",
+                    build_ms, teardown_ms, requests);
+  }
+  do_not_optimize(sum);
+  return 0;
+}
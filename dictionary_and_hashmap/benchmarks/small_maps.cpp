@@ -0,0 +1,75 @@
+// Construction time and memory of many small maps, with 0 to 32 entries
+// each: a HashMap (whose table is allocated on the first insert) and
+// SmallHashMaps with 8 and 32 inline entries. Memory is the size of the
+// object plus the heap it still holds once built.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+#include <cstdlib>
+#include <new>
+
+static size_t live_bytes = 0, allocations = 0;
+
+// Counts the heap in use: every block starts with its size.
+void* operator new(size_t size)
+{
+  size_t *block = (size_t *) std::malloc(size + sizeof(max_align_t));
+  if (block == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  *block = size;
+  live_bytes += size;
+  allocations++;
+  return (char *) block + sizeof(max_align_t);
+}
+
+void operator delete(void *ptr) noexcept
+{
+  if (ptr != nullptr)
+  {
+    size_t *block = (size_t *) ((char *) ptr - sizeof(max_align_t));
+    live_bytes -= *block;
+    std::free(block);
+  }
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+  operator delete(ptr);
+}
+
+template <typename MapT>
+void measure(const std::string &name, int entries, size_t maps)
+{
+  std::vector<MapT> built;
+  built.reserve(maps);
+  size_t bytes_before = live_bytes, allocations_before = allocations;
+  Timer timer;
+  for (size_t i = 0 ; i < maps ; i++)
+  {
+    built.emplace_back();
+    for (int k = 0 ; k < entries ; k++)
+    {
+      built.back().insert(k, k);
+    }
+  }
+  double ms = timer.elapsed_ms();
+  std::cout << name << " x " << entries << ": " << ms * 1e6 / maps
+            << " ns, " << (double) (allocations - allocations_before) / maps
+            << " allocations, "
+            << sizeof(MapT) + (double) (live_bytes - bytes_before) / maps
+            << " bytes per map" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  size_t maps = arg_or_default(argc, argv, 100000);
+  for (int entries : {0, 1, 2, 4, 8, 16, 32})
+  {
+    measure<HashMap<int, int>>("HashMap", entries, maps);
+    measure<SmallHashMap<int, int>>("SmallHashMap<8>", entries, maps);
+    measure<SmallHashMap<int, int, 32>>("SmallHashMap<32>", entries, maps);
+  }
+  return 0;
+}
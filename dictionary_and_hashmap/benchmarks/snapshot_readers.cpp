@@ -0,0 +1,109 @@
+// Read throughput of a configuration Dictionary with 1 to all hardware
+// reader threads, while a writer updates one entry every 20 ms: a
+// mutex-wrapped Dictionary against SnapshotDictionary. Build with -pthread.
+
+#include "../SnapshotMap.hpp"
+#include "BenchUtils.hpp"
+#include <thread>
+
+const int KEYS = 10000;
+const int READS_PER_THREAD = 1 << 20;
+
+class MutexDictionary
+{
+ public:
+  explicit MutexDictionary(const Dictionary &dict) : _dict(dict) {}
+
+  size_t value_size(const std::string &key) const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _dict.at(key).size();
+  }
+
+  void insert_or_assign(const std::string &key, const std::string &value)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _dict.insert_or_assign(key, value);
+  }
+
+ private:
+  mutable std::mutex _mutex;
+  Dictionary _dict;
+};
+
+class Snapshot
+{
+ public:
+  explicit Snapshot(const Dictionary &dict) : _dict(dict) {}
+
+  size_t value_size(const std::string &key) const
+  { return _dict.read()->at(key).size(); }
+
+  void insert_or_assign(const std::string &key, const std::string &value)
+  { _dict.insert_or_assign(key, value); }
+
+ private:
+  SnapshotDictionary _dict;
+};
+
+template <typename Map>
+double run(Map &map, const std::vector<std::string> &keys, int readers)
+{
+  std::atomic<bool> done{false};
+  std::thread writer([&map, &keys, &done] {
+    for (int i = 0 ; !done.load() ; i++)
+    {
+      map.insert_or_assign(keys[i % KEYS], std::to_string(i));
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  });
+  std::vector<std::thread> threads;
+  Timer timer;
+  for (int t = 0 ; t < readers ; t++)
+  {
+    threads.emplace_back([&map, &keys, t] {
+      size_t total = 0;
+      for (int i = 0 ; i < READS_PER_THREAD ; i++)
+      {
+        total += map.value_size(keys[((size_t) i * 7919 + t) % KEYS]);
+      }
+      do_not_optimize(total);
+    });
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+  double seconds = timer.elapsed_ms() / 1000;
+  done.store(true);
+  writer.join();
+  return readers * (double) READS_PER_THREAD / seconds / 1e6;
+}
+
+int main()
+{
+  std::vector<std::string> keys = random_keys(KEYS, 16);
+  Dictionary config;
+  for (const std::string &key : keys)
+  {
+    config.insert(key, key + key);
+  }
+  int max_threads = (int) std::max(1u, std::thread::hardware_concurrency());
+  std::vector<int> reader_counts;
+  for (int readers = 1 ; readers < max_threads ; readers *= 2)
+  {
+    reader_counts.push_back(readers);
+  }
+  reader_counts.push_back(max_threads);
+  std::cout << "reads (Mops/s):" << std::endl;
+  for (int readers : reader_counts)
+  {
+    MutexDictionary locked(config);
+    Snapshot snapshot(config);
+    double locked_mops = run(locked, keys, readers);
+    double snapshot_mops = run(snapshot, keys, readers);
+    std::cout << "  " << readers << " readers: mutex " << locked_mops
+              << ", snapshot " << snapshot_mops << std::endl;
+  }
+  return 0;
+}
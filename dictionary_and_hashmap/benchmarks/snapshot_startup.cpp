@@ -0,0 +1,67 @@
+// Startup time of a large Dictionary: parsing a "key\tvalue" text file and
+// inserting every entry, against opening a snapshot of it with mmap.
+
+#include "../DictionarySnapshot.hpp"
+#include "BenchUtils.hpp"
+#include <cstdio>
+#include <fstream>
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 2000000);
+  const std::string text_path = "/tmp/dictionary_bench.txt";
+  const std::string snapshot_path = "/tmp/dictionary_bench.snap";
+  std::vector<std::string> keys = random_keys(n, 20);
+  {
+    std::vector<std::string> values = random_keys(n, 40, 9);
+    std::ofstream text(text_path);
+    for (size_t i = 0 ; i < n ; i++)
+    {
+      text << keys[i] << '\t' << values[i] << '\n';
+    }
+  }
+
+  Timer rebuild_timer;
+  Dictionary dict;
+  {
+    std::ifstream text(text_path);
+    std::string line;
+    while (std::getline(text, line))
+    {
+      size_t tab = line.find('\t');
+      dict.insert(line.substr(0, tab), line.substr(tab + 1));
+    }
+  }
+  double rebuild_ms = rebuild_timer.elapsed_ms();
+  std::cout << "rebuild from text: " << rebuild_ms << " ms" << std::endl;
+
+  Timer write_timer;
+  write_snapshot(dict, snapshot_path);
+  std::cout << "write snapshot: " << write_timer.elapsed_ms() << " ms"
+            << std::endl;
+
+  Timer open_timer;
+  MappedDictionary mapped(snapshot_path);
+  double open_ms = open_timer.elapsed_ms();
+  size_t total = mapped.at(keys[0]).size();
+  double first_ms = open_timer.elapsed_ms();
+  std::cout << "open snapshot: " << open_ms << " ms (" << first_ms
+            << " ms including the first lookup)" << std::endl;
+
+  Timer lookup_timer;
+  for (const std::string &key : keys)
+  {
+    total += mapped.at(key).size();
+  }
+  report("mapped lookups", lookup_timer.elapsed_ms(), keys.size());
+  Timer dict_timer;
+  for (const std::string &key : keys)
+  {
+    total += dict.at(key).size();
+  }
+  report("Dictionary lookups", dict_timer.elapsed_ms(), keys.size());
+  do_not_optimize(total);
+  std::remove(text_path.c_str());
+  std::remove(snapshot_path.c_str());
+  return 0;
+}
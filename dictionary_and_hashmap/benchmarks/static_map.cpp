@@ -0,0 +1,98 @@
+// Lookups in small fixed tables, HTTP status codes and command names, in a
+// StaticHashMap built by the compiler and in a HashMap filled at startup.
+// The keys are read from a shuffled array, so neither lookup can be folded.
+
+#include "../StaticHashMap.hpp"
+#include "BenchUtils.hpp"
+
+constexpr auto STATUS_CODES = make_static_map<int, std::string_view>({
+    {100, "Continue"}, {101, "Switching Protocols"}, {200, "OK"},
+    {201, "Created"}, {202, "Accepted"}, {204, "No Content"},
+    {206, "Partial Content"}, {301, "Moved Permanently"}, {302, "Found"},
+    {303, "See Other"}, {304, "Not Modified"}, {307, "Temporary Redirect"},
+    {308, "Permanent Redirect"}, {400, "Bad Request"},
+    {401, "Unauthorized"}, {403, "Forbidden"}, {404, "Not Found"},
+    {405, "Method Not Allowed"}, {406, "Not Acceptable"},
+    {408, "Request Timeout"}, {409, "Conflict"}, {410, "Gone"},
+    {413, "Payload Too Large"}, {414, "URI Too Long"},
+    {415, "Unsupported Media Type"}, {429, "Too Many Requests"},
+    {500, "Internal Server Error"}, {501, "Not Implemented"},
+    {502, "Bad Gateway"}, {503, "Service Unavailable"},
+    {504, "Gateway Timeout"}});
+
+constexpr auto COMMANDS = make_static_map<std::string_view, int>({
+    {"get", 0}, {"set", 1}, {"del", 2}, {"exists", 3}, {"expire", 4},
+    {"ttl", 5}, {"incr", 6}, {"decr", 7}, {"append", 8}, {"strlen", 9},
+    {"mget", 10}, {"mset", 11}, {"keys", 12}, {"scan", 13}, {"type", 14},
+    {"rename", 15}, {"lpush", 16}, {"rpush", 17}, {"lpop", 18},
+    {"rpop", 19}, {"llen", 20}, {"hget", 21}, {"hset", 22}, {"hdel", 23},
+    {"sadd", 24}, {"srem", 25}, {"ping", 26}, {"echo", 27}, {"quit", 28},
+    {"flushall", 29}});
+
+static_assert(COMMANDS.at("ping") == 26, "looked up at compile time");
+
+// Lookups of keys drawn from the static map's, in a random order.
+template <typename KeyT, typename StaticMapT>
+std::vector<KeyT> lookup_keys(const StaticMapT &map, size_t n)
+{
+  std::vector<KeyT> keys;
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    keys.push_back(KeyT(map.begin()[i % map.size()].first));
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+  return keys;
+}
+
+template <typename MapT, typename KeyT>
+void measure(const std::string &name, const MapT &map,
+             const std::vector<KeyT> &keys)
+{
+  size_t sum = 0;
+  Timer timer;
+  for (const KeyT &key : keys)
+  {
+    sum += map.at(key).size();
+  }
+  do_not_optimize(sum);
+  report(name, timer.elapsed_ms(), keys.size());
+}
+
+template <typename MapT, typename KeyT>
+void measure_values(const std::string &name, const MapT &map,
+                    const std::vector<KeyT> &keys)
+{
+  long sum = 0;
+  Timer timer;
+  for (const KeyT &key : keys)
+  {
+    sum += map.at(key);
+  }
+  do_not_optimize(sum);
+  report(name, timer.elapsed_ms(), keys.size());
+}
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 20000000);
+
+  HashMap<int, std::string_view> status_codes;
+  for (const auto &pair : STATUS_CODES)
+  {
+    status_codes.insert(pair.first, pair.second);
+  }
+  std::vector<int> codes = lookup_keys<int>(STATUS_CODES, n);
+  measure("status codes, StaticHashMap", STATUS_CODES, codes);
+  measure("status codes, HashMap", status_codes, codes);
+
+  HashMap<std::string, int> commands;
+  for (const auto &pair : COMMANDS)
+  {
+    commands.insert(std::string(pair.first), pair.second);
+  }
+  std::vector<std::string_view> names =
+      lookup_keys<std::string_view>(COMMANDS, n);
+  measure_values("commands, StaticHashMap", COMMANDS, names);
+  measure_values("commands, HashMap", commands, names);
+  return 0;
+}
@@ -0,0 +1,38 @@
+// Cost of leaving stats enabled: inserts and lookups (half of them misses)
+// with stats off and on, then the stats of the last map as JSON.
+
+#include "../HashMap.hpp"
+#include "BenchUtils.hpp"
+
+HashMapStats measure(const std::string &name, bool enabled, size_t n)
+{
+  HashMap<long, long> map;
+  map.set_stats_enabled(enabled);
+  Timer insert_timer;
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    map.insert((long) i, (long) i);
+  }
+  double insert_ms = insert_timer.elapsed_ms();
+
+  long sum = 0;
+  Timer lookup_timer;
+  for (size_t i = 0 ; i < 2 * n ; i++)
+  {
+    sum += map.contains_key((long) i);
+  }
+  double lookup_ms = lookup_timer.elapsed_ms();
+  do_not_optimize(sum);
+  std::cout << name << ": insert " << insert_ms * 1e6 / n << " ns, lookup "
+            << lookup_ms * 1e6 / (2 * n) << " ns" << std::endl;
+  return map.stats();
+}
+
+int main(int argc, char **argv)
+{
+  size_t n = arg_or_default(argc, argv, 2000000);
+  measure("stats off", false, n);
+  HashMapStats stats = measure("stats on", true, n);
+  std::cout << stats.to_json() << std::endl;
+  return 0;
+}
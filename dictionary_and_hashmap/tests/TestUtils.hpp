@@ -0,0 +1,40 @@
+#ifndef _TEST_UTILS_HPP_
+#define _TEST_UTILS_HPP_
+
+#include <atomic>
+#include <iostream>
+
+// Shared helpers of the HashMap tests. Every test is a standalone program,
+// built from the dictionary_and_hashmap directory with e.g.
+//   g++ -std=c++17 -g -fsanitize=address -I. tests/<name>.cpp -o test
+// and run with ./test.
+// It prints every failed check and exits with 1 if there was one.
+
+// Atomic, for checks made by several threads.
+inline std::atomic<int> &failed_checks()
+{
+  static std::atomic<int> failed(0);
+  return failed;
+}
+
+#define CHECK(condition) \
+  do \
+  { \
+    if (!(condition)) \
+    { \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": failed: " \
+                << #condition << std::endl; \
+      failed_checks()++; \
+    } \
+  } while (false)
+
+inline int test_result()
+{
+  if (failed_checks() == 0)
+  {
+    std::cout << "OK" << std::endl;
+  }
+  return failed_checks() == 0 ? 0 : 1;
+}
+
+#endif //_TEST_UTILS_HPP_
@@ -0,0 +1,69 @@
+// Inserting a value that refers into the map itself, e.g.
+// map.insert(key, map.at(other)), in every state an insert can change: the
+// inline entries spilling to a table, the table growing, and an incremental
+// migration moving buckets. The value must be read before any of these.
+
+#include "../Dictionary.hpp"
+#include "TestUtils.hpp"
+
+template <typename MapT>
+void fill(MapT &map, int n)
+{
+  for (int i = 0 ; i < n ; i++)
+  {
+    map.insert(i, std::string(40, (char) ('a' + i % 26)));
+  }
+}
+
+template <typename MapT>
+void check_inserts_from_itself(MapT &map, int n, int inserts)
+{
+  for (int i = 0 ; i < inserts ; i++)
+  {
+    int key = n + i;
+    std::string expected = map.at(i);
+    CHECK(map.insert(key, map.at(i)));
+    CHECK(map.at(key) == expected);
+    CHECK(map.try_emplace(key + 1000, map.at(i)));
+    CHECK(map.at(key + 1000) == expected);
+    CHECK(map.insert_or_assign(key + 2000, map.at(key)));
+    CHECK(map.at(key + 2000) == expected);
+    map.emplace(key + 3000, map.at(i));
+    CHECK(map.at(key + 3000) == expected);
+  }
+}
+
+int main()
+{
+  // Grows at 12 entries of 16 buckets.
+  HashMap<int, std::string> grown;
+  fill(grown, 12);
+  check_inserts_from_itself(grown, 12, 100);
+
+  // Spills its 4 inline entries to a table.
+  HashMap<int, std::string, HashMapHash<int>, std::equal_to<int>, 4> small;
+  fill(small, 4);
+  check_inserts_from_itself(small, 4, 100);
+
+  // Migrates buckets on every insert.
+  HashMap<int, std::string> incremental;
+  incremental.set_incremental_rehash(true);
+  fill(incremental, 12);
+  check_inserts_from_itself(incremental, 12, 100);
+
+  // Dictionary::update assigns values read from the dictionary itself.
+  Dictionary dictionary;
+  for (int i = 0 ; i < 12 ; i++)
+  {
+    dictionary.insert(std::to_string(i), std::string(40, 'x'));
+  }
+  std::vector<std::pair<std::string, std::string>> pairs;
+  for (int i = 0 ; i < 100 ; i++)
+  {
+    pairs.emplace_back(std::to_string(100 + i), std::string(40, 'y'));
+  }
+  dictionary.update(pairs.begin(), pairs.end());
+  CHECK(dictionary.size() == 112);
+  CHECK(dictionary.at("150") == std::string(40, 'y'));
+  return test_result();
+}
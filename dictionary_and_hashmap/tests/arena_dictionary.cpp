@@ -0,0 +1,110 @@
+// ArenaDictionary against a std::map given the same inserts, assignments
+// and erases, with and without value interning. Interned values are shared
+// by their keys and released with the last one; assigning a key the value
+// it already has stores nothing, even when no other key shares that value.
+
+#include "../ArenaDictionary.hpp"
+#include "TestUtils.hpp"
+#include <map>
+#include <string>
+
+void check_same(const ArenaDictionary &dict,
+                const std::map<std::string, std::string> &model)
+{
+  CHECK(dict.size() == (int) model.size());
+  for (const auto &pair : model)
+  {
+    CHECK(dict.contains_key(pair.first) && dict.at(pair.first) == pair.second);
+  }
+}
+
+void check_operations(bool intern_values)
+{
+  ArenaDictionary dict(intern_values);
+  std::map<std::string, std::string> model;
+  for (int i = 0 ; i < 2000 ; i++)
+  {
+    std::string key = "key " + std::to_string(i * 7 % 500);
+    std::string value = "value " + std::to_string(i % 13);
+    switch (i % 4)
+    {
+      case 0:
+        CHECK(dict.insert(key, value) == model.emplace(key, value).second);
+        break;
+      case 1:
+      case 2:
+        CHECK(dict.insert_or_assign(key, value) ==
+              model.insert_or_assign(key, value).second);
+        break;
+      default:
+        if (model.erase(key) == 1)
+        {
+          CHECK(dict.erase(key));
+        }
+        else
+        {
+          try
+          {
+            dict.erase(key);
+            CHECK(false);
+          }
+          catch (const InvalidKey &)
+          {
+          }
+        }
+    }
+  }
+  check_same(dict, model);
+
+  // A value read from the dictionary points into its arena.
+  std::string_view other = dict.at(model.begin()->first);
+  dict.insert_or_assign("aliased", other);
+  CHECK(dict.at("aliased") == model.begin()->second);
+}
+
+void check_interning()
+{
+  ArenaDictionary dict(true);
+  dict.insert("a", "shared");
+  dict.insert("b", "shared");
+  dict.insert("c", "own");
+  CHECK(dict.interned_values() == 2);
+  CHECK(dict.at("a").data() == dict.at("b").data());
+
+  // The only key with "own" keeps it without storing it again.
+  size_t stored = dict.arena().stored_bytes();
+  CHECK(!dict.insert_or_assign("c", "own"));
+  CHECK(!dict.insert_or_assign("a", "shared"));
+  CHECK(dict.arena().stored_bytes() == stored);
+  CHECK(dict.interned_values() == 2 && dict.at("c") == "own");
+
+  CHECK(!dict.insert_or_assign("c", "shared"));
+  CHECK(dict.interned_values() == 1);
+  CHECK(!dict.insert("a", "other"));
+  CHECK(dict.erase("a") && dict.erase("b"));
+  CHECK(dict.interned_values() == 1 && dict.at("c") == "shared");
+  CHECK(dict.erase("c"));
+  CHECK(dict.interned_values() == 0 && dict.empty());
+}
+
+void check_no_needless_store()
+{
+  ArenaDictionary dict;
+  CHECK(dict.insert("key", "value"));
+  size_t stored = dict.arena().stored_bytes();
+  CHECK(!dict.insert("key", "other"));
+  CHECK(!dict.insert_or_assign("key", "value"));
+  CHECK(dict.arena().stored_bytes() == stored);
+  CHECK(!dict.insert_or_assign("key", "other"));
+  CHECK(dict.arena().stored_bytes() == stored + 5);
+  CHECK(dict.at("key") == "other");
+}
+
+int main()
+{
+  check_operations(false);
+  check_operations(true);
+  check_interning();
+  check_no_needless_store();
+  return test_result();
+}
@@ -0,0 +1,62 @@
+// bucket_index and bucket_size describe the same bucket in every state of
+// the map: inline entries (all in bucket 0), a table, and an incremental
+// migration, where keys not moved yet are numbered in the old table after
+// the new one. Also, a map spilling its inline entries allocates the table
+// the insert needs at once instead of rehashing it right after.
+
+#include "../HashMap.hpp"
+#include "TestUtils.hpp"
+#include <map>
+
+// Each bucket holds as many keys as bucket_size reports for them.
+template <typename MapT>
+void check_buckets(const MapT &map, int n)
+{
+  std::map<int, int> keys_in;
+  for (int key = 0 ; key < n ; key++)
+  {
+    keys_in[map.bucket_index(key)]++;
+  }
+  for (int key = 0 ; key < n ; key++)
+  {
+    CHECK(keys_in[map.bucket_index(key)] == map.bucket_size(key));
+  }
+}
+
+int main()
+{
+  HashMap<int, int, HashMapHash<int>, std::equal_to<>, 8> small;
+  for (int key = 0 ; key < 8 ; key++)
+  {
+    small.insert(key, key);
+  }
+  check_buckets(small, 8);
+  CHECK(small.bucket_index(5) == 0 && small.bucket_size(5) == 8);
+
+  HashMap<int, int> migrating;
+  migrating.set_incremental_rehash(true);
+  bool checked_migration = false;
+  for (int key = 0 ; key < 2000 ; key++)
+  {
+    migrating.insert(key, key);
+    if (migrating.migrating())
+    {
+      check_buckets(migrating, key + 1);
+      checked_migration = true;
+    }
+  }
+  CHECK(checked_migration);
+  check_buckets(migrating, 2000);
+
+  // 17 entries need 32 buckets at the default upper load factor.
+  HashMap<int, int, HashMapHash<int>, std::equal_to<>, 16> spilled;
+  spilled.set_stats_enabled(true);
+  for (int key = 0 ; key < 17 ; key++)
+  {
+    spilled.insert(key, key);
+  }
+  CHECK(spilled.capacity() == 32);
+  CHECK(spilled.stats().rehashes == 0);
+  check_buckets(spilled, 17);
+  return test_result();
+}
@@ -0,0 +1,88 @@
+// Several threads using one ConcurrentHashMap at once: each writer inserts,
+// assigns and erases keys of its own, while readers look up keys every
+// writer assigns, whose value is always derived from the key. With one
+// shard every operation contends for the same lock; with more, threads
+// mostly take different ones. Build this one with -fsanitize=thread too.
+
+#include "../ConcurrentHashMap.hpp"
+#include "TestUtils.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef ConcurrentHashMap<int, std::string> MapT;
+
+const int SHARED_KEYS = 100, OWN_KEYS = 500, WRITERS = 4, READERS = 4;
+
+std::string value_of(int key)
+{
+  return std::string(20, (char) ('a' + key % 26)) + std::to_string(key);
+}
+
+// Inserts its own keys, assigns the shared ones, and erases the odd ones of
+// its own.
+void write(MapT &map, int writer)
+{
+  int first = SHARED_KEYS + writer * OWN_KEYS;
+  for (int key = first ; key < first + OWN_KEYS ; key++)
+  {
+    CHECK(map.insert(key, value_of(key)));
+    CHECK(!map.insert_or_assign(key % SHARED_KEYS, value_of(key % SHARED_KEYS)));
+  }
+  for (int key = first + 1 ; key < first + OWN_KEYS ; key += 2)
+  {
+    CHECK(map.erase(key));
+  }
+}
+
+void read(const MapT &map)
+{
+  for (int round = 0 ; round < 20 ; round++)
+  {
+    for (int key = 0 ; key < SHARED_KEYS ; key++)
+    {
+      std::string value;
+      CHECK(map.find(key, value) && value == value_of(key));
+      CHECK(map.contains_key(key) && map.at(key) == value_of(key));
+    }
+    std::string value;
+    CHECK(!map.find(-1, value));
+  }
+}
+
+void check_threads(int shards)
+{
+  MapT map(shards);
+  for (int key = 0 ; key < SHARED_KEYS ; key++)
+  {
+    map.insert(key, value_of(key));
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0 ; i < WRITERS ; i++)
+  {
+    threads.emplace_back(write, std::ref(map), i);
+  }
+  for (int i = 0 ; i < READERS ; i++)
+  {
+    threads.emplace_back(read, std::cref(map));
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+  CHECK(map.size() == SHARED_KEYS + WRITERS * OWN_KEYS / 2);
+  for (int key = 0 ; key < SHARED_KEYS + WRITERS * OWN_KEYS ; key++)
+  {
+    std::string value;
+    bool kept = key < SHARED_KEYS || (key - SHARED_KEYS) % 2 == 0;
+    CHECK(map.find(key, value) == kept);
+    CHECK(!kept || value == value_of(key));
+  }
+}
+
+int main()
+{
+  check_threads(1);
+  check_threads(DEFAULT_SHARD_COUNT);
+  return test_result();
+}
@@ -0,0 +1,182 @@
+// Copies sharing their tables: a copy keeps sharing through lookups and
+// through changes that turn out not to be needed (inserting a present key,
+// erasing a missing one), detaches on a real change without the other map
+// seeing it, and isn't shared while a non-const reference into it may be
+// alive. Then copies of one map are read and modified by several threads;
+// build this one with -fsanitize=thread too.
+
+#include "../HashMap.hpp"
+#include "TestUtils.hpp"
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+typedef HashMap<int, std::string> MapT;
+
+const int KEYS = 200;
+
+std::string value_of(int key)
+{
+  return std::string(30, (char) ('a' + key % 26)) + std::to_string(key);
+}
+
+void fill(MapT &map)
+{
+  for (int i = 0 ; i < KEYS ; i++)
+  {
+    map.insert(i, value_of(i));
+  }
+}
+
+// Whether the maps share their tables: const lookups don't detach, so they
+// find the same value.
+bool sharing(const MapT &a, const MapT &b, int key)
+{
+  return &a.at(key) == &b.at(key);
+}
+
+void check_unchanged(const MapT &map)
+{
+  CHECK(map.size() == KEYS);
+  for (int i = 0 ; i < KEYS ; i++)
+  {
+    CHECK(map.contains_key(i) && map.at(i) == value_of(i));
+  }
+}
+
+void check_no_needless_detach()
+{
+  MapT original;
+  fill(original);
+  MapT copy(original);
+  CHECK(sharing(original, copy, 0));
+  CHECK(!copy.insert(1, "other"));
+  CHECK(!copy.try_emplace(2, "other"));
+  CHECK(!copy.emplace(3, "other"));
+  CHECK(!copy.erase(KEYS));
+  int missing[] = {KEYS, KEYS + 1};
+  CHECK(copy.erase(missing, missing + 2) == 0);
+  std::string taken;
+  CHECK(!copy.take(KEYS, taken) && copy.find(KEYS) == nullptr);
+  try
+  {
+    copy.at(KEYS);
+    CHECK(false);
+  }
+  catch (const std::out_of_range &)
+  {
+  }
+  CHECK(sharing(original, copy, 0));
+  check_unchanged(copy);
+}
+
+void check_changes_detach()
+{
+  MapT original;
+  fill(original);
+
+  MapT assigned(original);
+  CHECK(!assigned.insert_or_assign(1, std::string("assigned")));
+  CHECK(!sharing(original, assigned, 0));
+  CHECK(assigned.at(1) == "assigned");
+
+  MapT inserted(original);
+  CHECK(inserted.insert(KEYS, "new"));
+  CHECK(!sharing(original, inserted, 0));
+  CHECK(inserted.size() == KEYS + 1 && inserted.at(KEYS) == "new");
+
+  MapT erased(original);
+  CHECK(erased.erase(1));
+  CHECK(!sharing(original, erased, 0));
+  CHECK(erased.size() == KEYS - 1 && !erased.contains_key(1));
+
+  MapT taken(original);
+  std::string value;
+  CHECK(taken.take(1, value) && value == value_of(1));
+  CHECK(!sharing(original, taken, 0));
+  CHECK(taken.size() == KEYS - 1 && !taken.contains_key(1));
+
+  MapT written(original);
+  written.at(2) = "written";
+  written[3] = "written";
+  *written.find(4) = "written";
+  CHECK(!sharing(original, written, 0));
+  CHECK(written.at(2) == "written" && written.at(3) == "written");
+  CHECK(written.at(4) == "written");
+
+  // Changing the original doesn't show in a copy either.
+  MapT copy(original);
+  original.at(4) = "written";
+  CHECK(copy.at(4) == value_of(4));
+  original.at(4) = value_of(4);
+  check_unchanged(original);
+}
+
+void check_unshareable()
+{
+  MapT original;
+  fill(original);
+  std::string &value = original.at(5);
+  MapT copy(original);
+  CHECK(!sharing(original, copy, 0));
+  value = "written";
+  CHECK(copy.at(5) == value_of(5));
+  value = value_of(5);
+
+  // A full rehash moves every entry, so no reference points into the new
+  // table and the map may be shared again.
+  original.reserve(4 * KEYS);
+  MapT shared(original);
+  CHECK(sharing(original, shared, 0));
+  check_unchanged(shared);
+}
+
+// Each thread copies the map, reads every key of its copy, changes the copy
+// and checks that it sees only its own changes.
+void use_copy(const MapT &original, int thread, int rounds)
+{
+  for (int round = 0 ; round < rounds ; round++)
+  {
+    MapT copy(original);
+    check_unchanged(copy);
+    int key = (thread * rounds + round) % KEYS;
+    CHECK(!copy.insert(key, "ignored"));
+    CHECK(!copy.erase(KEYS));
+    std::string own = "thread " + std::to_string(thread);
+    copy.insert_or_assign(key, own);
+    CHECK(copy.erase((key + 1) % KEYS));
+    copy.insert(KEYS + thread, own);
+    CHECK(copy.size() == KEYS);
+    CHECK(copy.at(key) == own && copy.at(KEYS + thread) == own);
+    CHECK(!copy.contains_key((key + 1) % KEYS));
+  }
+}
+
+void check_threads(bool incremental)
+{
+  MapT original;
+  original.set_incremental_rehash(incremental);
+  fill(original);
+  const int threads = 4;
+  std::vector<std::thread> workers;
+  for (int i = 0 ; i < threads ; i++)
+  {
+    workers.emplace_back(use_copy, std::cref(original), i, 50);
+  }
+  for (std::thread &worker : workers)
+  {
+    worker.join();
+  }
+  check_unchanged(original);
+}
+
+int main()
+{
+  check_no_needless_detach();
+  check_changes_detach();
+  check_unshareable();
+  check_threads(false);
+  check_threads(true);
+  return test_result();
+}
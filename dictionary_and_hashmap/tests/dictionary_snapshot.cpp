@@ -0,0 +1,217 @@
+// A Dictionary written with write_snapshot reads back the same through
+// MappedDictionary, and rewriting the snapshot replaces the file instead of
+// changing the one an open MappedDictionary maps. A corrupt header makes
+// opening throw, and corrupt bucket starts or entries make the lookups
+// reading them throw, instead of reading outside the file.
+
+#include "../DictionarySnapshot.hpp"
+#include "TestUtils.hpp"
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+const int KEYS = 300;
+
+std::string path_of(const std::string &name)
+{
+  return "/tmp/dictionary_snapshot_test_" + std::to_string(getpid()) + "_" +
+         name;
+}
+
+std::string read_file(const std::string &path)
+{
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream bytes;
+  bytes << in.rdbuf();
+  return bytes.str();
+}
+
+void write_file(const std::string &path, const std::string &bytes)
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), bytes.size());
+}
+
+Dictionary make_dictionary(const std::string &suffix)
+{
+  Dictionary dict;
+  for (int i = 0 ; i < KEYS ; i++)
+  {
+    dict.insert("key " + std::to_string(i), std::to_string(i) + suffix);
+  }
+  dict.insert("", "empty key");
+  dict.insert("empty value", "");
+  return dict;
+}
+
+void check_same(const Dictionary &dict, const MappedDictionary &mapped)
+{
+  CHECK(mapped.size() == dict.size());
+  for (const auto &pair : dict)
+  {
+    CHECK(mapped.contains_key(pair.first) && mapped.at(pair.first) == pair.second);
+  }
+  CHECK(!mapped.contains_key("key " + std::to_string(KEYS)));
+  try
+  {
+    mapped.at("missing");
+    CHECK(false);
+  }
+  catch (const std::out_of_range &)
+  {
+  }
+}
+
+void check_round_trip()
+{
+  std::string path = path_of("round_trip");
+  Dictionary dict = make_dictionary(" first");
+  write_snapshot(dict, path);
+  {
+    MappedDictionary mapped(path);
+    check_same(dict, mapped);
+
+    Dictionary rewritten = make_dictionary(" second");
+    write_snapshot(rewritten, path);
+    check_same(dict, mapped);
+    check_same(rewritten, MappedDictionary(path));
+  }
+
+  Dictionary empty;
+  write_snapshot(empty, path);
+  MappedDictionary mapped(path);
+  CHECK(mapped.empty() && !mapped.contains_key(""));
+  unlink(path.c_str());
+}
+
+// Whether opening the snapshot changed by corrupt throws.
+bool open_fails(const std::string &bytes,
+                const std::function<void(std::string &)> &corrupt)
+{
+  std::string path = path_of("corrupt");
+  std::string changed = bytes;
+  corrupt(changed);
+  write_file(path, changed);
+  bool failed = false;
+  try
+  {
+    MappedDictionary mapped(path);
+  }
+  catch (const std::runtime_error &)
+  {
+    failed = true;
+  }
+  unlink(path.c_str());
+  return failed;
+}
+
+// Changes the header of a snapshot.
+std::function<void(std::string &)>
+header_change(const std::function<void(SnapshotHeader &)> &change)
+{
+  return [change](std::string &bytes)
+         {
+           SnapshotHeader header;
+           std::memcpy(&header, bytes.data(), sizeof(header));
+           change(header);
+           std::memcpy(&bytes[0], &header, sizeof(header));
+         };
+}
+
+void check_corrupt_header()
+{
+  std::string path = path_of("valid");
+  write_snapshot(make_dictionary(""), path);
+  std::string bytes = read_file(path);
+  unlink(path.c_str());
+  CHECK(!open_fails(bytes, [](std::string &) {}));
+
+  CHECK(open_fails(bytes, [](std::string &b) { b.resize(sizeof(SnapshotHeader) - 1); }));
+  CHECK(open_fails(bytes, [](std::string &b) { b.pop_back(); }));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.magic[0] = 'X'; })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.version++; })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.bucket_count = 0; })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.bucket_count += 1; })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.bucket_count *= 2; })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.buckets_offset = 0; })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.buckets_offset += 1; })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.entry_count++; })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.strings_offset++; })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h) { h.file_size--; })));
+  // Offsets whose sums wrap around to pass unchecked arithmetic.
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h)
+                                        {
+                                          h.buckets_offset = UINT64_MAX - 3;
+                                        })));
+  CHECK(open_fails(bytes, header_change([](SnapshotHeader &h)
+                                        {
+                                          h.entry_count += UINT64_MAX /
+                                                           sizeof(SnapshotEntry) + 1;
+                                        })));
+}
+
+// Lookups of every key throw once the bucket starts or entries are corrupt.
+void check_corrupt_entries()
+{
+  std::string path = path_of("entries");
+  Dictionary dict = make_dictionary("");
+  write_snapshot(dict, path);
+  std::string bytes = read_file(path);
+  SnapshotHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+
+  auto lookups_fail = [&](const std::function<void(std::string &)> &corrupt)
+  {
+    std::string changed = bytes;
+    corrupt(changed);
+    write_file(path, changed);
+    MappedDictionary mapped(path);
+    int failed = 0;
+    for (const auto &pair : dict)
+    {
+      try
+      {
+        mapped.at(pair.first);
+      }
+      catch (const std::runtime_error &)
+      {
+        failed++;
+      }
+    }
+    return failed == dict.size();
+  };
+
+  CHECK(lookups_fail([&header](std::string &b)
+                     {
+                       auto *starts = (uint32_t *) &b[header.buckets_offset];
+                       for (uint32_t i = 0 ; i < header.bucket_count ; i++)
+                       {
+                         starts[i] = (uint32_t) header.entry_count + 5;
+                       }
+                     }));
+  CHECK(lookups_fail([&header](std::string &b)
+                     {
+                       auto *entries = (SnapshotEntry *) &b[header.entries_offset];
+                       for (uint64_t i = 0 ; i < header.entry_count ; i++)
+                       {
+                         entries[i].key_offset = UINT64_MAX - 2;
+                       }
+                     }));
+  CHECK(lookups_fail([&header](std::string &b)
+                     {
+                       auto *entries = (SnapshotEntry *) &b[header.entries_offset];
+                       for (uint64_t i = 0 ; i < header.entry_count ; i++)
+                       {
+                         entries[i].value_length = (uint32_t) b.size();
+                       }
+                     }));
+  unlink(path.c_str());
+}
+
+int main()
+{
+  check_round_trip();
+  check_corrupt_header();
+  check_corrupt_entries();
+  return test_result();
+}
@@ -0,0 +1,84 @@
+// FrozenHashMaps of no keys, one key and a few keys, and of keys that all
+// collide so that none of them is placed by the perfect hash: every key must
+// be found, and iterated over once, and lookups of missing keys must find
+// nothing.
+
+#include "../FrozenHashMap.hpp"
+#include "TestUtils.hpp"
+#include <vector>
+
+// Every key below 1000 hashes alike, so no pilot can place two of them.
+struct CollidingHash
+{
+  size_t operator()(int key) const
+  { return key < 1000 ? 7 : mix_hash(key); }
+};
+
+template <typename HashT>
+void check_frozen(int n)
+{
+  HashMap<int, int, HashT> map;
+  for (int i = 0 ; i < n ; i++)
+  {
+    map.insert(i, -i);
+  }
+  FrozenHashMap<int, int, HashT> frozen(map);
+  CHECK(frozen.size() == n);
+  CHECK(frozen.empty() == (n == 0));
+  for (int i = 0 ; i < n ; i++)
+  {
+    CHECK(frozen.contains_key(i));
+    CHECK(frozen.at(i) == -i);
+  }
+  std::vector<int> seen(n, 0);
+  int iterated = 0;
+  for (const auto &pair : frozen)
+  {
+    CHECK(pair.first >= 0 && pair.first < n && pair.second == -pair.first);
+    if (pair.first >= 0 && pair.first < n)
+    {
+      seen[pair.first]++;
+    }
+    iterated++;
+  }
+  CHECK(iterated == n);
+  CHECK(std::count(seen.begin(), seen.end(), 1) == n);
+  for (int i = n ; i < n + 100 ; i++)
+  {
+    CHECK(!frozen.contains_key(i));
+  }
+  for (int i = 1000 ; i < 1100 ; i++)
+  {
+    CHECK(!frozen.contains_key(i));
+  }
+  bool thrown = false;
+  try
+  {
+    frozen.at(n);
+  }
+  catch (const std::out_of_range &)
+  {
+    thrown = true;
+  }
+  CHECK(thrown);
+}
+
+int main()
+{
+  for (int n : {0, 1, 2, 3, 5, 8, 13, 100})
+  {
+    check_frozen<HashMapHash<int>>(n);
+    check_frozen<CollidingHash>(n);
+  }
+
+  FrozenDictionary empty((Dictionary()));
+  CHECK(empty.size() == 0);
+  CHECK(!empty.contains_key("x"));
+  CHECK(!empty.contains_key(std::string_view("")));
+  CHECK(empty.begin() == empty.end());
+
+  FrozenDictionary one(Dictionary({"a"}, {"1"}));
+  CHECK(one.at("a") == "1");
+  CHECK(!one.contains_key("b"));
+  return test_result();
+}
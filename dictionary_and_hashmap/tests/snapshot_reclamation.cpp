@@ -0,0 +1,135 @@
+// SnapshotMap frees replaced snapshots only once no reader can see them:
+// a snapshot held by a read guard survives writes, and is freed by the
+// next write or reclaim() after the guard is gone. Then readers check that
+// the snapshots they read are whole while a writer replaces them, and every
+// replaced snapshot is freed at the end; build this one with
+// -fsanitize=thread too.
+
+#include "../SnapshotMap.hpp"
+#include "TestUtils.hpp"
+#include <thread>
+#include <vector>
+
+const int KEYS = 50;
+
+// A map counting its live instances, to see the snapshots being freed.
+struct CountedMap : HashMap<int, int>
+{
+  static std::atomic<int> &live()
+  {
+    static std::atomic<int> count(0);
+    return count;
+  }
+
+  CountedMap()
+  { live()++; }
+
+  CountedMap(const CountedMap &other) : HashMap<int, int>(other)
+  { live()++; }
+
+  ~CountedMap()
+  { live()--; }
+};
+
+typedef SnapshotMap<CountedMap> MapT;
+
+// Every snapshot holds the keys 0..KEYS-1, all with the same value.
+void write_version(MapT &map, int version)
+{
+  map.modify([version](CountedMap &snapshot)
+             {
+               for (int key = 0 ; key < KEYS ; key++)
+               {
+                 snapshot.insert_or_assign(key, version);
+               }
+             });
+}
+
+bool whole(const CountedMap &snapshot)
+{
+  if (snapshot.size() != KEYS)
+  {
+    return false;
+  }
+  int version = snapshot.at(0);
+  for (int key = 1 ; key < KEYS ; key++)
+  {
+    if (snapshot.at(key) != version)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void check_guard_keeps_snapshot()
+{
+  MapT map;
+  write_version(map, 1);
+  {
+    MapT::ReadGuard guard = map.read();
+    write_version(map, 2);
+    write_version(map, 3);
+    // The snapshot of version 1 is still read; version 2 may be freed.
+    CHECK(map.pending_reclamation() >= 1);
+    CHECK(whole(*guard) && guard->at(0) == 1);
+    {
+      MapT::ReadGuard nested = map.read();
+      CHECK(nested->at(0) == 3);
+    }
+    CHECK(guard->at(0) == 1);
+  }
+  // Retained until the next write or reclaim().
+  CHECK(CountedMap::live() > 1);
+  map.reclaim();
+  CHECK(map.pending_reclamation() == 0);
+  CHECK(CountedMap::live() == 1);
+}
+
+void read(const MapT &map, const std::atomic<bool> &done)
+{
+  int last = 0;
+  while (!done.load())
+  {
+    MapT::ReadGuard guard = map.read();
+    CHECK(whole(*guard));
+    // Versions only grow.
+    CHECK(guard->at(0) >= last);
+    last = guard->at(0);
+  }
+}
+
+void check_threads()
+{
+  MapT map;
+  write_version(map, 0);
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int i = 0 ; i < 4 ; i++)
+  {
+    readers.emplace_back(read, std::cref(map), std::cref(done));
+  }
+  for (int version = 1 ; version <= 500 ; version++)
+  {
+    write_version(map, version);
+  }
+  done.store(true);
+  for (std::thread &reader : readers)
+  {
+    reader.join();
+  }
+  // The readers are gone, so the next write frees every replaced snapshot.
+  write_version(map, 501);
+  CHECK(map.pending_reclamation() == 0);
+  CHECK(CountedMap::live() == 1);
+  CHECK(map.read()->at(0) == 501);
+}
+
+int main()
+{
+  check_guard_keeps_snapshot();
+  CHECK(CountedMap::live() == 0);
+  check_threads();
+  CHECK(CountedMap::live() == 0);
+  return test_result();
+}
@@ -0,0 +1,66 @@
+#ifndef _BENCH_UTILS_H_
+#define _BENCH_UTILS_H_
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+/**
+ * Shared helpers of the vl_vector benchmarks. Every benchmark is a standalone
+ * program, built by "make benchmarks" into bench_<name>.
+ */
+
+/**
+ * Measures the time since it was created.
+ */
+class Timer {
+ public:
+  Timer () : _start (std::chrono::steady_clock::now ()) {}
+
+  /**
+   * Returns the time since the timer was created.
+   * @return the elapsed time in milliseconds.
+   */
+  double elapsed_ms () const
+  {
+    return std::chrono::duration<double, std::milli>
+        (std::chrono::steady_clock::now () - _start).count ();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point _start;
+};
+
+/**
+ * Keeps the compiler from optimizing away a computed value.
+ * @param value the value to keep.
+ */
+template <class T>
+inline void do_not_optimize (const T &value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Returns the first command line argument as a number, if there is one.
+ * @param def the number to return if there is no argument.
+ */
+inline size_t arg_or_default (int argc, char **argv, size_t def)
+{
+  return argc > 1 ? std::strtoul (argv[1], nullptr, 10) : def;
+}
+
+/**
+ * Prints the total time and the time per operation.
+ * @param name what was measured.
+ * @param ms the total time in milliseconds.
+ * @param ops the number of operations.
+ */
+inline void report (const std::string &name, double ms, size_t ops)
+{
+  std::cout << name << ": " << ms << " ms, " << (ms * 1e6 / ops)
+            << " ns/op" << std::endl;
+}
+
+#endif //_BENCH_UTILS_H_
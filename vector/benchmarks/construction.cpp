@@ -0,0 +1,73 @@
+/**
+ * Cost of vl_vectors of element types that are expensive to construct: many
+ * vectors built empty, with a few elements, and grown past their static
+ * capacity. Prints the time and the number of elements constructed per
+ * vector, which is what the static storage used to cost up front.
+ */
+
+#include "../vl_vector.h"
+#include "bench_utils.h"
+#include <string>
+#include <vector>
+
+static size_t constructions = 0;
+
+/**
+ * An element that allocates when default constructed, like a std::string
+ * or a std::vector with a reserved buffer.
+ */
+struct Expensive {
+  std::vector<int> buffer;
+
+  Expensive () : buffer (16) {constructions++;}
+  explicit Expensive (int value) : buffer (16, value) {constructions++;}
+  Expensive (const Expensive &other) : buffer (other.buffer)
+  {constructions++;}
+  Expensive &operator= (const Expensive &other) = default;
+  bool operator== (const Expensive &other) const
+  {return buffer == other.buffer;}
+};
+
+/**
+ * Builds the given number of vectors with count elements each.
+ */
+template <class VectorT, class T>
+void measure (const std::string &name, size_t vectors, int count,
+              const T &value)
+{
+  constructions = 0;
+  Timer timer;
+  for (size_t i = 0; i < vectors; i++)
+    {
+      VectorT vector;
+      for (int j = 0; j < count; j++)
+        {vector.push_back (value);}
+      do_not_optimize (vector.data ());
+    }
+  double ms = timer.elapsed_ms ();
+  std::cout << name << ", " << count << " elements: " << ms * 1e6 / vectors
+            << " ns/vector";
+  if (constructions > 0)
+    {
+      std::cout << ", " << (double) constructions / vectors
+                << " constructions/vector";
+    }
+  std::cout << std::endl;
+}
+
+int main (int argc, char **argv)
+{
+  size_t vectors = arg_or_default (argc, argv, 100000);
+  for (int count : {0, 4, 100})
+    {
+      measure<vl_vector<Expensive, 64>> ("vl_vector<Expensive, 64>", vectors,
+                                         count, Expensive (1));
+    }
+  for (int count : {0, 4, 100})
+    {
+      measure<vl_vector<std::string, 64>> ("vl_vector<std::string, 64>",
+                                           vectors, count,
+                                           std::string (32, 'x'));
+    }
+  return 0;
+}
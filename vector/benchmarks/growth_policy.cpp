@@ -0,0 +1,73 @@
+/**
+ * Appending to vl_vector<int> with each growth policy, and after reserve:
+ * the time per push_back, the number of reallocations and the capacity
+ * left over at the end, for one large vector and for many that spill just
+ * past their static capacity.
+ */
+
+#include "../vl_vector.h"
+#include "bench_utils.h"
+#include <vector>
+
+/**
+ * Appends count values to each of the vectors, reserving them first if
+ * asked to, and counts the times the capacity changed.
+ */
+template <class VectorT>
+__attribute__ ((noinline)) size_t append (std::vector<VectorT> &vectors,
+                                          size_t count, bool reserve)
+{
+  size_t reallocations = 0;
+  for (VectorT &vector : vectors)
+    {
+      if (reserve)
+        {vector.reserve (count);}
+      size_t capacity = vector.capacity ();
+      for (size_t i = 0; i < count; i++)
+        {
+          vector.push_back ((int) i);
+          if (vector.capacity () != capacity)
+            {
+              capacity = vector.capacity ();
+              reallocations++;
+            }
+        }
+    }
+  return reallocations;
+}
+
+/**
+ * Times appending count values to each of rounds vectors.
+ */
+template <class VectorT>
+void measure (const std::string &name, size_t count, size_t rounds,
+              bool reserve = false)
+{
+  std::vector<VectorT> vectors (rounds);
+  Timer timer;
+  size_t reallocations = append (vectors, count, reserve);
+  double ms = timer.elapsed_ms ();
+  do_not_optimize (vectors.back ().data ());
+  std::cout << name << ", " << count << " elements: "
+            << ms * 1e6 / (count * rounds) << " ns/push_back, "
+            << (double) reallocations / rounds << " reallocations, capacity "
+            << vectors.back ().capacity () << std::endl;
+}
+
+int main (int argc, char **argv)
+{
+  size_t count = arg_or_default (argc, argv, 10000000);
+
+  measure<vl_vector<int, 16, grow_1_5x>> ("1.5x", count, 1);
+  measure<vl_vector<int, 16, grow_2x>> ("2x", count, 1);
+  measure<vl_vector<int, 16, grow_page_rounded>> ("page rounded", count, 1);
+  measure<vl_vector<int, 16, grow_1_5x>> ("1.5x, reserved", count, 1, true);
+
+  measure<vl_vector<int, 16, grow_1_5x>> ("1.5x", 100, count / 100);
+  measure<vl_vector<int, 16, grow_2x>> ("2x", 100, count / 100);
+  measure<vl_vector<int, 16, grow_page_rounded>> ("page rounded", 100,
+                                                  count / 100);
+  measure<vl_vector<int, 16, grow_1_5x>> ("1.5x, reserved", 100, count / 100,
+                                          true);
+  return 0;
+}
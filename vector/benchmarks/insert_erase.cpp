@@ -0,0 +1,62 @@
+/**
+ * Inserting and erasing in the middle of a large vl_vector<int> and of a
+ * large vl_string, which shifts every element after the position, and
+ * growing them, which relocates every element. Elements of these types are
+ * moved with memmove.
+ */
+
+#include "../vl_string.h"
+#include "bench_utils.h"
+
+/**
+ * Times inserting ops values in the middle of a vector of size elements,
+ * then erasing them from there again, one at a time and 16 at a time.
+ */
+template <class VectorT, class T>
+void insert_erase (const std::string &name, VectorT &vector, size_t ops,
+                   T value)
+{
+  Timer insert_timer;
+  for (size_t i = 0; i < ops; i++)
+    {vector.insert (vector.cbegin () + vector.size () / 2, value);}
+  report (name + ", insert in the middle", insert_timer.elapsed_ms (), ops);
+
+  Timer erase_timer;
+  for (size_t i = 0; i < ops; i++)
+    {vector.erase (vector.cbegin () + vector.size () / 2);}
+  report (name + ", erase in the middle", erase_timer.elapsed_ms (), ops);
+
+  T values[16];
+  std::fill (values, values + 16, value);
+  Timer range_timer;
+  for (size_t i = 0; i < ops / 16; i++)
+    {
+      auto middle = vector.cbegin () + vector.size () / 2;
+      vector.insert (middle, values, values + 16);
+      middle = vector.cbegin () + vector.size () / 2;
+      vector.erase (middle, middle + 16);
+    }
+  report (name + ", insert and erase 16 in the middle",
+          range_timer.elapsed_ms (), ops / 16);
+}
+
+int main (int argc, char **argv)
+{
+  size_t size = arg_or_default (argc, argv, 1000000);
+  size_t ops = 2000;
+
+  Timer vector_timer;
+  vl_vector<int> vector;
+  for (size_t i = 0; i < size; i++)
+    {vector.push_back ((int) i);}
+  report ("vl_vector<int>, push_back", vector_timer.elapsed_ms (), size);
+  insert_erase ("vl_vector<int>", vector, ops, 42);
+
+  Timer string_timer;
+  vl_string<> string;
+  for (size_t i = 0; i < size; i++)
+    {string.push_back ((char) ('a' + i % 26));}
+  report ("vl_string, push_back", string_timer.elapsed_ms (), size);
+  insert_erase ("vl_string", string, ops, 'x');
+  return 0;
+}
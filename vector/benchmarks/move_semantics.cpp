@@ -0,0 +1,69 @@
+/**
+ * Vectors of std::string and std::vector<int> elements, which own heap
+ * memory: appending temporaries, inserting at the front and moving whole
+ * vectors, both spilled and static. Every copy of an element allocates; a
+ * move doesn't.
+ */
+
+#include "../vl_vector.h"
+#include "bench_utils.h"
+#include <string>
+#include <vector>
+
+/**
+ * Times appending n temporaries, then inserting n / 100 of them at the front.
+ */
+template <class T, class MakeT>
+void append_and_insert (const std::string &name, size_t n, MakeT make)
+{
+  vl_vector<T, 16> vector;
+  Timer append_timer;
+  for (size_t i = 0; i < n; i++)
+    {vector.push_back (make (i));}
+  report (name + ", push_back", append_timer.elapsed_ms (), n);
+
+  Timer insert_timer;
+  for (size_t i = 0; i < n / 100; i++)
+    {vector.insert (vector.begin (), make (i));}
+  report (name + ", insert at front", insert_timer.elapsed_ms (), n / 100);
+}
+
+/**
+ * Times moving a vector of the given size back and forth.
+ */
+template <class T, class MakeT>
+void move_vectors (const std::string &name, size_t size, size_t moves,
+                   MakeT make)
+{
+  vl_vector<T, 16> first, second;
+  for (size_t i = 0; i < size; i++)
+    {first.push_back (make (i));}
+  Timer timer;
+  for (size_t i = 0; i < moves; i++)
+    {
+      second = std::move (first);
+      first = std::move (second);
+    }
+  do_not_optimize (first.data ());
+  report (name + ", move " + std::to_string (size) + " elements",
+          timer.elapsed_ms (), 2 * moves);
+}
+
+int main (int argc, char **argv)
+{
+  size_t n = arg_or_default (argc, argv, 100000);
+  auto make_string = [] (size_t i)
+  {return std::string (48, (char) ('a' + i % 26));};
+  auto make_vector = [] (size_t i)
+  {return std::vector<int> (32, (int) i);};
+
+  append_and_insert<std::string> ("std::string", n, make_string);
+  append_and_insert<std::vector<int>> ("std::vector<int>", n, make_vector);
+  for (size_t size : {8, 1000})
+    {
+      move_vectors<std::string> ("std::string", size, 20000, make_string);
+      move_vectors<std::vector<int>> ("std::vector<int>", size, 20000,
+                                      make_vector);
+    }
+  return 0;
+}
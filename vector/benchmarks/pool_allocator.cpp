@@ -0,0 +1,73 @@
+/**
+ * Many threads building short-lived vl_vector<int>s and vl_strings that
+ * spill past their static capacity, with operator new and with
+ * pool_allocator. Every spilled vector allocates and frees a few buffers of
+ * the same sizes; the pool serves them from the cache of the thread.
+ * Prints the time per vector over all the threads, for 1, 2, 4... threads
+ * up to the number of cores, or 4.
+ */
+
+#include "../vl_string.h"
+#include "../pool_allocator.h"
+#include "bench_utils.h"
+#include <thread>
+#include <vector>
+
+/**
+ * Builds the given number of vectors of 17 to 100 elements each.
+ */
+template <class VectorT, class T>
+void build (size_t vectors, T value)
+{
+  size_t checksum = 0;
+  for (size_t i = 0; i < vectors; i++)
+    {
+      VectorT vector;
+      size_t count = 17 + i % 84;
+      for (size_t j = 0; j < count; j++)
+        {vector.push_back (value);}
+      checksum += vector.size ();
+    }
+  do_not_optimize (checksum);
+}
+
+/**
+ * Times threads threads building vectors vectors each.
+ */
+template <class VectorT, class T>
+void measure (const std::string &name, size_t threads, size_t vectors,
+              T value)
+{
+  std::vector<std::thread> workers;
+  Timer timer;
+  for (size_t i = 0; i < threads; i++)
+    {workers.emplace_back (build<VectorT, T>, vectors, value);}
+  for (std::thread &worker : workers)
+    {worker.join ();}
+  double ms = timer.elapsed_ms ();
+  std::cout << name << ", " << threads << " threads: "
+            << ms * 1e6 / (threads * vectors) << " ns/vector" << std::endl;
+}
+
+int main (int argc, char **argv)
+{
+  size_t vectors = arg_or_default (argc, argv, 1000000);
+  // At least 4, to show the contention even on a machine with fewer cores.
+  size_t max_threads = std::max (std::thread::hardware_concurrency (), 4U);
+
+  typedef vl_vector<int, 16> new_vector;
+  typedef vl_vector<int, 16, grow_1_5x, pool_allocator<int>> pool_vector;
+  typedef vl_string<16> new_string;
+  typedef vl_string<16, grow_1_5x, pool_allocator<char>> pool_string;
+  for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+      measure<new_vector> ("vl_vector<int>, operator new", threads, vectors,
+                           1);
+      measure<pool_vector> ("vl_vector<int>, pool_allocator", threads,
+                            vectors, 1);
+      measure<new_string> ("vl_string, operator new", threads, vectors, 'a');
+      measure<pool_string> ("vl_string, pool_allocator", threads, vectors,
+                            'a');
+    }
+  return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * The hot loops of vl_vector<int> and vl_string: appending with push_back,
+ * summing by index up to size () and popping until empty (). The loops run
+ * in functions that aren't inlined and take the vector by reference, as
+ * library code would, so the compiler can't tell its dynamic type. Also
+ * prints the size of the objects.
+ */
+
+#include "../vl_string.h"
+#include "bench_utils.h"
+#include <vector>
+
+/**
+ * Appends count values to the vector.
+ */
+template <class VectorT, class T>
+__attribute__ ((noinline)) void append (VectorT &vector, size_t count,
+                                        T value)
+{
+  for (size_t i = 0; i < count; i++)
+    {vector.push_back (value);}
+}
+
+/**
+ * Sums the elements of the vector by index.
+ */
+template <class VectorT>
+__attribute__ ((noinline)) long sum (const VectorT &vector)
+{
+  long total = 0;
+  for (size_t i = 0; i < vector.size (); i++)
+    {total += vector[i];}
+  return total;
+}
+
+/**
+ * Pops the elements of the vector one at a time.
+ */
+template <class VectorT>
+__attribute__ ((noinline)) void drain (VectorT &vector)
+{
+  while (!vector.empty ())
+    {vector.pop_back ();}
+}
+
+/**
+ * Times the three loops on rounds vectors of count elements each.
+ */
+template <class VectorT, class T>
+void measure (const std::string &name, size_t count, size_t rounds, T value)
+{
+  std::vector<VectorT> vectors (rounds);
+  Timer append_timer;
+  for (VectorT &vector : vectors)
+    {append (vector, count, value);}
+  double append_ms = append_timer.elapsed_ms ();
+
+  long total = 0;
+  Timer sum_timer;
+  for (const VectorT &vector : vectors)
+    {total += sum (vector);}
+  double sum_ms = sum_timer.elapsed_ms ();
+  do_not_optimize (total);
+
+  Timer drain_timer;
+  for (VectorT &vector : vectors)
+    {drain (vector);}
+  double drain_ms = drain_timer.elapsed_ms ();
+
+  std::string label = name + ", " + std::to_string (count) + " elements";
+  report (label + ", push_back", append_ms, count * rounds);
+  report (label + ", sum by index", sum_ms, count * rounds);
+  report (label + ", pop_back", drain_ms, count * rounds);
+}
+
+int main (int argc, char **argv)
+{
+  size_t count = arg_or_default (argc, argv, 1000000);
+
+  std::cout << "sizeof (vl_vector<int>): " << sizeof (vl_vector<int>)
+            << ", sizeof (vl_string<>): " << sizeof (vl_string<>)
+            << std::endl;
+  measure<vl_vector<int>> ("vl_vector<int>", count, 10, 1);
+  measure<vl_vector<int>> ("vl_vector<int>", 16, count / 2, 1);
+  measure<vl_string<>> ("vl_string", count, 10, 'a');
+  measure<vl_string<>> ("vl_string", 15, count / 2, 'a');
+  return 0;
+}
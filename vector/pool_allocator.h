@@ -0,0 +1,192 @@
+#ifndef _POOL_ALLOCATOR_H_
+#define _POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#define POOL_GRANULARITY 16UL
+#define POOL_MAX_BLOCK 4096UL
+#define POOL_CLASSES (POOL_MAX_BLOCK / POOL_GRANULARITY)
+#define POOL_CACHE_BYTES 65536UL
+
+/**
+ * The per-thread cache of pool_allocator: a free list of blocks for each
+ * size class, a multiple of POOL_GRANULARITY bytes up to POOL_MAX_BLOCK.
+ *
+ * The classes are fine grained because of the way vl_vectors spill: cap_c
+ * gives every vl_vector type the same few capacities as it grows (e.g. 25,
+ * 39, 60... elements for a static capacity of 16), so each of these byte
+ * sizes gets a class of its own and a freed buffer is reused by the next
+ * vector to spill to the same size without a call to operator new, which
+ * threads share. Larger blocks, like the ones of grow_page_rounded, go to
+ * operator new directly.
+ *
+ * A class keeps at most POOL_CACHE_BYTES of free blocks; the rest are
+ * freed. A block is allocated by operator new on its own, so it may be
+ * freed by any thread, into that thread's cache, and a thread frees its
+ * cache when it exits.
+ */
+class pool_cache {
+ public:
+  /**
+   * Allocates a block of at least the given size from the cache of the
+   * current thread.
+   * @param bytes the size of the block.
+   * @return a pointer to the block.
+   */
+  static void *allocate (size_t bytes)
+  {
+    if (bytes > POOL_MAX_BLOCK)
+      {return ::operator new (bytes);}
+    size_t index = size_class (bytes);
+    if (!destroyed ())
+      {
+        pool_cache &cache = local ();
+        free_block *block = cache._lists[index];
+        if (block != nullptr)
+          {
+            cache._lists[index] = block->next;
+            cache._counts[index]--;
+            return block;
+          }
+      }
+    // The whole class, as another thread may cache the block when freed.
+    return ::operator new ((index + 1) * POOL_GRANULARITY);
+  }
+
+  /**
+   * Returns a block to the cache of the current thread, or frees it if the
+   * cache of its class is full.
+   * @param pointer the block, returned by allocate.
+   * @param bytes the size it was allocated with.
+   */
+  static void deallocate (void *pointer, size_t bytes)
+  {
+    if (bytes > POOL_MAX_BLOCK || destroyed ())
+      {
+        ::operator delete (pointer);
+        return;
+      }
+    size_t index = size_class (bytes);
+    pool_cache &cache = local ();
+    if (cache._counts[index] * (index + 1) * POOL_GRANULARITY
+        >= POOL_CACHE_BYTES)
+      {
+        ::operator delete (pointer);
+        return;
+      }
+    free_block *block = static_cast<free_block *> (pointer);
+    block->next = cache._lists[index];
+    cache._lists[index] = block;
+    cache._counts[index]++;
+  }
+
+ private:
+  /**
+   * A free block, linked through its own memory.
+   */
+  struct free_block {
+    free_block *next;
+  };
+
+  free_block *_lists[POOL_CLASSES] = {};
+  size_t _counts[POOL_CLASSES] = {};
+
+  pool_cache () = default;
+
+  /**
+   * Frees the cached blocks when the thread exits. Blocks freed after that
+   * (e.g. by other thread_local objects) go to operator delete.
+   */
+  ~pool_cache ()
+  {
+    for (free_block *block : _lists)
+      {
+        while (block != nullptr)
+          {
+            free_block *next = block->next;
+            ::operator delete (block);
+            block = next;
+          }
+      }
+    destroyed () = true;
+  }
+
+  /**
+   * Returns the index of the class of a block of the given size.
+   * @param bytes the size of the block, at most POOL_MAX_BLOCK.
+   */
+  static size_t size_class (size_t bytes)
+  {return (bytes == 0 ? 0 : (bytes - 1) / POOL_GRANULARITY);}
+
+  /**
+   * Returns the cache of the current thread.
+   */
+  static pool_cache &local ()
+  {
+    static thread_local pool_cache cache;
+    return cache;
+  }
+
+  /**
+   * Whether the cache of the current thread was destroyed. Trivial, so it
+   * outlives the cache.
+   */
+  static bool &destroyed ()
+  {
+    static thread_local bool is_destroyed = false;
+    return is_destroyed;
+  }
+};
+
+/**
+ * A stateless allocator over pool_cache, for the dynamic data of
+ * vl_vectors that spill often, e.g.
+ *   vl_vector<int, 16, grow_1_5x, pool_allocator<int>> vector;
+ * Elements must not need more alignment than operator new gives.
+ * @tparam T the type of the elements.
+ */
+template <class T>
+class pool_allocator {
+ public:
+  typedef T value_type;
+  typedef std::true_type is_always_equal;
+
+  pool_allocator () = default;
+
+  /**
+   * Converting Constructor, for rebinding to another element type.
+   */
+  template <class U>
+  pool_allocator (const pool_allocator<U> &) {}
+
+  /**
+   * Allocates uninitialized memory for the given number of elements.
+   * @param count the number of elements.
+   * @return a pointer to the allocated memory.
+   */
+  T *allocate (size_t count)
+  {return static_cast<T *> (pool_cache::allocate (count * sizeof (T)));}
+
+  /**
+   * Frees memory returned by allocate.
+   * @param buffer the memory to free.
+   * @param count the number of elements it was allocated for.
+   */
+  void deallocate (T *buffer, size_t count)
+  {pool_cache::deallocate (buffer, count * sizeof (T));}
+
+  /**
+   * All pool_allocators are equal: any of them may free the memory of
+   * another.
+   */
+  template <class U>
+  friend bool operator == (const pool_allocator &, const pool_allocator<U> &)
+  {return true;}
+
+  template <class U>
+  friend bool operator != (const pool_allocator &, const pool_allocator<U> &)
+  {return false;}
+};
+
+#endif //_POOL_ALLOCATOR_H_
@@ -0,0 +1,223 @@
+/**
+ * Elements whose copy throws, at every point of a copy: constructors free
+ * what they allocated, copy-assignment leaves an empty, usable vl_vector,
+ * and inserting or growing keeps the size, and the elements too unless a
+ * range is inserted among non-relocatable ones, which may be moved from.
+ * No element is leaked or destroyed twice, for relocatable and
+ * non-relocatable elements, kept in the static data and in dynamic data.
+ */
+
+#include "../vl_vector.h"
+#include "test_utils.h"
+#include <vector>
+
+/**
+ * The number of elements alive, and the number of copies left before one
+ * throws (none throws while it is negative).
+ */
+static int live = 0;
+static int copies_left = -1;
+
+/**
+ * Owns its value on the heap, so a leaked or doubly destroyed element shows
+ * up in the live count and to the address sanitizer.
+ */
+struct Element {
+  int *value;
+
+  explicit Element (int v) : value (new int (v)) {live++;}
+
+  Element (const Element &other) : value (nullptr)
+  {
+    if (copies_left == 0)
+      {throw 1;}
+    if (copies_left > 0)
+      {copies_left--;}
+    value = new int (*other.value);
+    live++;
+  }
+
+  Element (Element &&other) noexcept : value (other.value)
+  {
+    other.value = nullptr;
+    live++;
+  }
+
+  Element &operator= (const Element &other)
+  {
+    Element copy (other);
+    std::swap (value, copy.value);
+    return *this;
+  }
+
+  Element &operator= (Element &&other) noexcept
+  {
+    std::swap (value, other.value);
+    return *this;
+  }
+
+  ~Element ()
+  {
+    delete value;
+    live--;
+  }
+};
+
+/**
+ * The same, but relocated by memmove instead of by its move constructor.
+ */
+struct RelocatableElement : Element {
+  using Element::Element;
+};
+
+template <>
+struct is_trivially_relocatable<RelocatableElement> : std::true_type {};
+
+/**
+ * Calls f with copies failing after the given number of copies.
+ * @return true if f threw.
+ */
+template <class F>
+bool throws_after (int copies, F f)
+{
+  copies_left = copies;
+  bool thrown = false;
+  try
+    {f ();}
+  catch (int)
+    {thrown = true;}
+  copies_left = -1;
+  return thrown;
+}
+
+template <class T, class Vector>
+void fill (Vector &vector, int n, int first = 0)
+{
+  for (int i = 0; i < n; i++)
+    {vector.emplace_back (first + i);}
+}
+
+template <class Vector>
+bool holds (const Vector &vector, int n, int first = 0)
+{
+  if (vector.size () != (size_t) n)
+    {return false;}
+  for (int i = 0; i < n; i++)
+    {
+      if (*vector.data ()[i].value != first + i)
+        {return false;}
+    }
+  return true;
+}
+
+template <class T>
+void check_constructors (int n)
+{
+  typedef vl_vector<T, 4> Vector;
+  {
+    Vector source;
+    fill<T> (source, n);
+    std::vector<T> elements (source.begin (), source.end ());
+    for (int copies = 0; copies < n; copies++)
+      {
+        int before = live;
+        CHECK (throws_after (copies, [&source] {Vector copy (source);}));
+        CHECK (throws_after (copies, [&elements]
+          {Vector copy (elements.begin (), elements.end ());}));
+        CHECK (throws_after (copies, [&source, n]
+          {Vector copy ((size_t) n, source[0]);}));
+        CHECK (live == before);
+      }
+  }
+  CHECK (live == 0);
+}
+
+template <class T>
+void check_copy_assignment (int target_size, int source_size)
+{
+  typedef vl_vector<T, 4> Vector;
+  {
+    Vector source;
+    fill<T> (source, source_size, 100);
+    for (int copies = 0; copies < source_size; copies++)
+      {
+        Vector target;
+        fill<T> (target, target_size);
+        CHECK (throws_after (copies, [&target, &source] {target = source;}));
+        CHECK (target.empty ());
+        CHECK (live == source_size);
+        fill<T> (target, 10);
+        CHECK (holds (target, 10));
+        target = source;
+        CHECK (holds (target, source_size, 100));
+        CHECK (target.capacity () == source.capacity ());
+      }
+    Vector &alias = source;
+    source = alias;
+    CHECK (holds (source, source_size, 100));
+  }
+  CHECK (live == 0);
+}
+
+template <class T>
+void check_insert_and_growth ()
+{
+  typedef vl_vector<T, 4> Vector;
+  for (int position = 0; position <= 6; position++)
+    {
+      for (int copies = 0; copies < 3; copies++)
+        {
+          Vector vector;
+          fill<T> (vector, 6);
+          std::vector<T> range;
+          fill<T> (range, 3, 100);
+          CHECK (throws_after (copies, [&vector, &range, position]
+            {
+              vector.insert (vector.cbegin () + position, range.begin (),
+                             range.end ());
+            }));
+          CHECK (vector.size () == 6);
+          CHECK (!is_trivially_relocatable<T>::value || holds (vector, 6));
+          CHECK (live == 6 + 3);
+          vector.clear ();
+          fill<T> (vector, 6);
+          T one (7);
+          CHECK (throws_after (0, [&vector, &one, position]
+            {vector.insert (vector.cbegin () + position, one);}));
+          CHECK (holds (vector, 6));
+        }
+      CHECK (live == 0);
+    }
+
+  // Growing from the static data and from dynamic data.
+  for (int n : {4, 6})
+    {
+      Vector vector;
+      fill<T> (vector, n);
+      vector.shrink_to_fit ();
+      T one (7);
+      CHECK (throws_after (0, [&vector, &one] {vector.push_back (one);}));
+      CHECK (holds (vector, n));
+    }
+  CHECK (live == 0);
+}
+
+template <class T>
+void check_all ()
+{
+  for (int n : {1, 4, 9})
+    {check_constructors<T> (n);}
+  for (int target_size : {0, 3, 9, 16})
+    {
+      for (int source_size : {1, 4, 9, 16})
+        {check_copy_assignment<T> (target_size, source_size);}
+    }
+  check_insert_and_growth<T> ();
+}
+
+int main ()
+{
+  check_all<Element> ();
+  check_all<RelocatableElement> ();
+  return test_result ();
+}
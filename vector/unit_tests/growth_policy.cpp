@@ -0,0 +1,38 @@
+/**
+ * Every way a vl_vector gets dynamic data sizes it by its GrowthPolicy: the
+ * sequence and count constructors as well as push_back and insert. Vectors
+ * that fit in the static data stay there under every policy.
+ */
+
+#include "../vl_vector.h"
+#include "test_utils.h"
+#include <vector>
+
+template <class Policy>
+void check_policy ()
+{
+  typedef vl_vector<int, 4, Policy> Vector;
+  for (size_t n : {0, 3, 4, 5, 10, 1000, 5000})
+    {
+      size_t expected = Policy::capacity (EMPTY_SIZE, n, 4, sizeof (int));
+      std::vector<int> values (n, 7);
+      CHECK (Vector (values.begin (), values.end ()).capacity () == expected);
+      CHECK (Vector (n, 7).capacity () == expected);
+      Vector inserted;
+      inserted.insert (inserted.begin (), values.begin (), values.end ());
+      CHECK (inserted.capacity () == expected);
+      CHECK (expected >= n && (n > 4 || expected == 4));
+    }
+
+  Vector pushed ((size_t) 4, 7);
+  pushed.push_back (7);
+  CHECK (pushed.capacity () == Policy::capacity (4, 1, 4, sizeof (int)));
+}
+
+int main ()
+{
+  check_policy<grow_1_5x> ();
+  check_policy<grow_2x> ();
+  check_policy<grow_page_rounded> ();
+  return test_result ();
+}
@@ -0,0 +1,153 @@
+/**
+ * Elements that must not be moved by memmove (they point to themselves) are
+ * moved by their move constructor, and elements declared relocatable are
+ * moved by memmove without it, through growing, inserting, erasing,
+ * shrinking back to the static data and moving the vl_vector. Either way
+ * the values are those of a std::vector given the same operations.
+ */
+
+#include "../vl_vector.h"
+#include "test_utils.h"
+#include <vector>
+
+static int live = 0;
+static int moves = 0;
+
+/**
+ * Points to itself, so a copy of its bytes at another address is caught.
+ */
+struct Anchored {
+  int value;
+  const Anchored *self;
+
+  Anchored (int v) : value (v), self (this) {live++;}
+
+  Anchored (const Anchored &other) : value (other.value), self (this)
+  {live++;}
+
+  Anchored (Anchored &&other) noexcept : value (other.value), self (this)
+  {
+    live++;
+    moves++;
+  }
+
+  Anchored &operator= (const Anchored &other)
+  {
+    value = other.value;
+    return *this;
+  }
+
+  ~Anchored ()
+  {live--;}
+
+  bool intact () const
+  {return self == this;}
+};
+
+/**
+ * Owns its value on the heap; its moves are counted to see that vl_vector
+ * doesn't call them.
+ */
+struct Owning {
+  int *value;
+
+  Owning (int v) : value (new int (v)) {live++;}
+
+  Owning (const Owning &other) : value (new int (*other.value)) {live++;}
+
+  Owning (Owning &&other) noexcept : value (other.value)
+  {
+    other.value = nullptr;
+    live++;
+    moves++;
+  }
+
+  Owning &operator= (Owning other)
+  {
+    std::swap (value, other.value);
+    return *this;
+  }
+
+  ~Owning ()
+  {
+    delete value;
+    live--;
+  }
+
+  bool intact () const
+  {return value != nullptr;}
+};
+
+template <>
+struct is_trivially_relocatable<Owning> : std::true_type {};
+
+int value_of (const Anchored &element)
+{return element.value;}
+
+int value_of (const Owning &element)
+{return *element.value;}
+
+template <class Vector>
+bool same (const Vector &vector, const std::vector<int> &expected)
+{
+  if (vector.size () != expected.size ())
+    {return false;}
+  for (size_t i = 0; i < expected.size (); i++)
+    {
+      if (!vector.data ()[i].intact ()
+          || value_of (vector.data ()[i]) != expected[i])
+        {return false;}
+    }
+  return true;
+}
+
+template <class T>
+void check_relocation (bool relocatable)
+{
+  moves = 0;
+  {
+    typedef vl_vector<T, 4> Vector;
+    Vector vector;
+    std::vector<int> expected;
+    for (int i = 0; i < 20; i++)
+      {
+        vector.emplace_back (i);
+        expected.push_back (i);
+        CHECK (same (vector, expected));
+      }
+    vector.insert (vector.begin () + 3, T (100));
+    expected.insert (expected.begin () + 3, 100);
+    CHECK (same (vector, expected));
+    vector.erase (vector.begin () + 1, vector.begin () + 5);
+    expected.erase (expected.begin () + 1, expected.begin () + 5);
+    CHECK (same (vector, expected));
+
+    // Only relocations from here on, which call no move of a relocatable
+    // element.
+    moves = 0;
+    vector.reserve (100);
+    vector.shrink_to_fit ();
+    CHECK (same (vector, expected) && vector.capacity () == expected.size ());
+    vector.erase (vector.begin () + 1);
+    expected.erase (expected.begin () + 1);
+    CHECK (same (vector, expected));
+
+    // Back to the static data, and moved while there.
+    vector.erase (vector.begin () + 2, vector.end ());
+    expected.resize (2);
+    CHECK (same (vector, expected) && vector.capacity () == 4);
+    Vector moved (std::move (vector));
+    CHECK (same (moved, expected) && vector.empty ());
+    vector = std::move (moved);
+    CHECK (same (vector, expected) && moved.empty ());
+    CHECK ((moves == 0) == relocatable);
+  }
+  CHECK (live == 0);
+}
+
+int main ()
+{
+  check_relocation<Anchored> (false);
+  check_relocation<Owning> (true);
+  return test_result ();
+}
@@ -0,0 +1,59 @@
+/**
+ * Inserting an element of the vl_vector into itself: push_back, emplace_back,
+ * insert and emplace of one of its own elements give the same as in a
+ * std::vector, whether the insert grows the vl_vector (from the static data
+ * or from dynamic data), moves the source element, or neither.
+ */
+
+#include "../vl_vector.h"
+#include "../vl_string.h"
+#include "test_utils.h"
+#include <string>
+#include <vector>
+
+template <class T, class MakeT>
+void check_self_insert (MakeT make)
+{
+  for (int n = 1; n <= 12; n++)
+    {
+      vl_vector<T, 4> vector;
+      std::vector<T> expected;
+      for (int i = 0; i < n; i++)
+        {
+          vector.push_back (make (i));
+          expected.push_back (make (i));
+        }
+      // At n = 4 and after shrink_to_fit the vl_vector is full.
+      vector.shrink_to_fit ();
+      vector.push_back (vector[0]);
+      expected.push_back (expected[0]);
+      vector.shrink_to_fit ();
+      vector.emplace_back (vector[vector.size () - 1]);
+      expected.emplace_back (expected[expected.size () - 1]);
+      vector.shrink_to_fit ();
+      vector.insert (vector.begin (), vector[vector.size () - 1]);
+      expected.insert (expected.begin (), expected[expected.size () - 1]);
+      vector.insert (vector.begin () + 1, vector[vector.size () / 2]);
+      expected.insert (expected.begin () + 1, expected[expected.size () / 2]);
+      vector.emplace (vector.end () - 1, vector[1]);
+      expected.emplace (expected.end () - 1, expected[1]);
+      CHECK (std::vector<T> (vector.begin (), vector.end ()) == expected);
+    }
+}
+
+int main ()
+{
+  check_self_insert<int> ([] (int i) {return i;});
+  check_self_insert<std::string> ([] (int i)
+    {return std::string (40, (char) ('a' + i)) + std::to_string (i);});
+
+  vl_string<4> string ("a");
+  std::string expected = "a";
+  for (size_t i = 0; i < 100; i++)
+    {
+      string.push_back (string[i / 2]);
+      expected.push_back (expected[i / 2]);
+    }
+  CHECK (std::string (string) == expected);
+  return test_result ();
+}
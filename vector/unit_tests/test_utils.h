@@ -0,0 +1,46 @@
+#ifndef _TEST_UTILS_H_
+#define _TEST_UTILS_H_
+
+#include <iostream>
+
+/**
+ * Shared helpers of the vl_vector tests. Every test is a standalone program,
+ * built into test_<name> and run by "make run_unit_tests"; it prints every
+ * failed check and exits with 1 if there was one. Building one with e.g.
+ *   g++ -std=c++14 -g -fsanitize=address,undefined unit_tests/<name>.cpp
+ * also catches leaks and reads of destroyed elements.
+ */
+
+/**
+ * The number of failed checks so far.
+ * @return a reference to the counter.
+ */
+inline int &failed_checks ()
+{
+  static int failed = 0;
+  return failed;
+}
+
+#define CHECK(condition) \
+  do \
+    { \
+      if (!(condition)) \
+        { \
+          std::cerr << __FILE__ << ":" << __LINE__ << ": failed: " \
+                    << #condition << std::endl; \
+          failed_checks ()++; \
+        } \
+    } while (false)
+
+/**
+ * Prints OK if every check passed.
+ * @return the exit code of the test: 0 if every check passed, 1 otherwise.
+ */
+inline int test_result ()
+{
+  if (failed_checks () == 0)
+    {std::cout << "OK" << std::endl;}
+  return failed_checks () == 0 ? 0 : 1;
+}
+
+#endif //_TEST_UTILS_H_
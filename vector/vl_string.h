@@ -7,22 +7,37 @@
 #define TERMINATOR '\0'
 #define ERROR_INVALID_DATA "Error: Invalid data!\n"
 
-template <size_t StaticCapacity = DEFAULT_CAPACITY>
-class vl_string : public vl_vector<char, StaticCapacity>
+template <size_t StaticCapacity = DEFAULT_CAPACITY,
+          class GrowthPolicy = grow_1_5x,
+          class Allocator = std::allocator<char>>
+class vl_string
+    : public vl_vector<char, StaticCapacity, GrowthPolicy, Allocator>
 {
+  typedef vl_vector<char, StaticCapacity, GrowthPolicy, Allocator>
+      base_vector;
+
  public:
   /**
    * Default Constructor. Initializes an empty vl_string.
    */
-  vl_string () : vl_vector<char, StaticCapacity> (1, TERMINATOR) {}
+  vl_string () : base_vector (1, TERMINATOR) {}
 
   /**
    * Copy Constructor. Initializes a vl_string from another vl_string.
    * @param other another vl_string to initialize from.
    */
-  vl_string (const vl_string &other) : vl_vector<char, StaticCapacity> (other)
+  vl_string (const vl_string &other) : base_vector (other)
   {}
 
+  /**
+   * Move Constructor. Takes the characters of other, which is left an empty
+   * vl_string.
+   * @param other another vl_string to move from.
+   */
+  vl_string (vl_string &&other) noexcept (StaticCapacity > 0) :
+  base_vector (std::move (other))
+  {other.base_vector::push_back (TERMINATOR);}
+
   /**
    * Implicit Constructor. Initializes a vl_string from the given string
    * (const char *).
@@ -35,24 +50,61 @@ class vl_string : public vl_vector<char, StaticCapacity>
     this->insert (this->cend () - 1, string, string + strlen (string));
   }
 
+  /**
+   * Assigns to the vl_string.
+   * @param other another vl_string to assign from.
+   * @return a reference to the current vl_string that was changed.
+   */
+  vl_string &operator= (const vl_string &other) = default;
+
+  /**
+   * Move-assigns to the vl_string, leaving other an empty vl_string.
+   * @param other another vl_string to move from.
+   * @return a reference to the current vl_string that was changed.
+   */
+  vl_string &operator= (vl_string &&other) noexcept (StaticCapacity > 0)
+  {
+    if (this != &other)
+      {
+        base_vector::operator= (std::move (other));
+        other.base_vector::push_back (TERMINATOR);
+      }
+    return *this;
+  }
+
+  // The functions below hide (rather than override, nothing is virtual)
+  // the ones of vl_vector, to keep the terminator character out of the
+  // size and at the end of the data. The functions of vl_vector don't call
+  // them, so a vl_string must not be used through a reference to its base.
+
   /**
    * Returns the size of the vl_string (not including the terminator
    * character).
    * @return the value of the size field of the vl_vector minus one.
    */
-  size_t size () const override
+  size_t size () const
   {return (this->_size - 1);}
 
+  /**
+   * Checks if the vl_string is empty.
+   * @return true if it has only the terminator character, false otherwise.
+   */
+  bool empty () const
+  {return this->_size == 1;}
+
   /**
    * Adds the given character to the end of the vl_string.
    * @param value the given character to add at the end of the vl_string.
    */
-  void push_back (const char value) override
+  void push_back (const char &value)
   {
+    char character = value; // value may be in the data that is relocated.
     this->check_expand (1);
-    *(this->end () - 1) = value; // overwrite the terminator character.
-    this->_size++;
-    *(this->end () - 1) = TERMINATOR;
+    size_t size = this->_size; // read once: the stores below may alias it.
+    char *terminator = this->data () + size - 1;
+    terminator[0] = character; // overwrite the terminator character.
+    terminator[1] = TERMINATOR;
+    this->_size = size + 1;
   }
 
   /**
@@ -60,12 +112,11 @@ class vl_string : public vl_vector<char, StaticCapacity>
    * empty (it has only the terminator character), then the function
    * terminates.
    */
-  void pop_back () override
+  void pop_back ()
   {
     if (this->empty ())
       {return;}
-    this->check_shrink (1);
-    this->_size--;
+    base_vector::pop_back ();
     *(this->end () - 1) = TERMINATOR;
   }
 
@@ -73,13 +124,10 @@ class vl_string : public vl_vector<char, StaticCapacity>
    * Erases all the data from the vl_string. Puts the terminator character
    * at the end of the cleared vl_string.
    */
-  void clear () override
+  void clear ()
   {
-    this->_size = 1;
-    this->_capacity = StaticCapacity;
-    delete[] this->_dynamic_vector;
-    this->_dynamic_vector = nullptr;
-    *(this->end () - 1) = TERMINATOR;
+    base_vector::clear ();
+    base_vector::push_back (TERMINATOR);
   }
 
   /**
@@ -114,8 +162,7 @@ class vl_string : public vl_vector<char, StaticCapacity>
    * @param other the given vl_string to expand with.
    * @return the reference to the current vl_string.
    */
-  vl_string<StaticCapacity> &operator+= (const vl_string<StaticCapacity>
-      &other)
+  vl_string &operator+= (const vl_string &other)
   {
     this->insert (this->cend () - 1, other.begin (), other.begin () +
     other.size ());
@@ -128,7 +175,7 @@ class vl_string : public vl_vector<char, StaticCapacity>
    * @param other the given string to expand with.
    * @return the reference to the current vl_string.
    */
-  vl_string<StaticCapacity> &operator+= (const char *other)
+  vl_string &operator+= (const char *other)
   {
     if (other == nullptr)
       {throw std::invalid_argument (ERROR_INVALID_DATA);}
@@ -141,7 +188,7 @@ class vl_string : public vl_vector<char, StaticCapacity>
    * @param value the given character to expand with.
    * @return the reference to the current vl_string.
    */
-  vl_string<StaticCapacity> &operator += (const char value)
+  vl_string &operator += (const char value)
   {
     this->push_back (value);
     return *this;
@@ -153,8 +200,7 @@ class vl_string : public vl_vector<char, StaticCapacity>
    * @param rhs the second vl_string to add.
    * @return the obtained vl_string (the result of the sum).
    */
-  friend vl_string<StaticCapacity> operator+ (const vl_string<StaticCapacity>
-      &lhs, const vl_string<StaticCapacity> &rhs)
+  friend vl_string operator+ (const vl_string &lhs, const vl_string &rhs)
   {
     vl_string string (lhs);
     string += rhs;
@@ -168,8 +214,7 @@ class vl_string : public vl_vector<char, StaticCapacity>
    * @param rhs the string (const char *) to add.
    * @return the obtained vl_string (the result of the sum).
    */
-  friend vl_string<StaticCapacity> operator+ (const vl_string<StaticCapacity>
-      &lhs, const char *rhs)
+  friend vl_string operator+ (const vl_string &lhs, const char *rhs)
   {
     if (rhs == nullptr)
       {throw std::invalid_argument (ERROR_INVALID_DATA);}
@@ -184,8 +229,7 @@ class vl_string : public vl_vector<char, StaticCapacity>
    * @param rhs the character to add.
    * @return the obtained vl_string (the result of the sum).
    */
-  friend vl_string<StaticCapacity> operator+ (const vl_string<StaticCapacity>
-  &lhs, const char rhs)
+  friend vl_string operator+ (const vl_string &lhs, const char rhs)
   {
     vl_string string (lhs);
     string += rhs;
@@ -199,6 +243,10 @@ class vl_string : public vl_vector<char, StaticCapacity>
    */
   operator const char *() const
   {return this->data ();}
+
+ private:
+  // Would add the character after the terminator.
+  using base_vector::emplace_back;
 };
 
 #endif //_VL_STRING_H_
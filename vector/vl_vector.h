@@ -4,8 +4,14 @@
 #include <iostream>
 #include <iterator>
 #include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <cstring>
 #define EMPTY_SIZE 0
 #define DEFAULT_CAPACITY 16UL
+#define GROWTH_PAGE_SIZE 4096UL
 #define ERROR_OUT_OF_RANGE "Error: The given value is out of range!\n"
 
 /**
@@ -15,26 +21,164 @@
  * @param static_capacity the static capacity of the vl_vector.
  * @return a new capacity calculated by the formula.
  */
-size_t cap_c (size_t size, size_t num_add, size_t static_capacity)
+inline size_t cap_c (size_t size, size_t num_add, size_t static_capacity)
 {
   if (size + num_add <= static_capacity)
     {return static_capacity;}
-  return ((size_t) ((float) (3 * (size + num_add))) /
-  ((float) 2));
+  // In integers: a float is exact only up to 2^24 elements.
+  return (3 * (size + num_add)) / 2;
 }
 
-template <class T, size_t StaticCapacity = DEFAULT_CAPACITY>
+/**
+ * Growth policies of vl_vector: the capacity it grows to when size + num_add
+ * elements don't fit. Each one is a class with a static function of the
+ * signature of capacity below, passed as the GrowthPolicy parameter.
+ */
+
+/**
+ * Grows to 1.5 times the needed size, by cap_c. The default: it wastes at
+ * most a third of the memory, and a freed buffer can be reused by a later
+ * growth.
+ */
+struct grow_1_5x {
+  /**
+   * @param size the current size of the vl_vector.
+   * @param num_add the number of elements to add to the vl_vector.
+   * @param static_capacity the static capacity of the vl_vector.
+   * @param element_size the size of an element in bytes.
+   * @return the new capacity, at least size + num_add.
+   */
+  static size_t capacity (size_t size, size_t num_add, size_t static_capacity,
+                          size_t element_size)
+  {
+    (void) element_size;
+    return cap_c (size, num_add, static_capacity);
+  }
+};
+
+/**
+ * Grows to twice the needed size: fewer reallocations for vectors that are
+ * appended to a lot, at the cost of up to half the memory.
+ */
+struct grow_2x {
+  static size_t capacity (size_t size, size_t num_add, size_t static_capacity,
+                          size_t element_size)
+  {
+    (void) element_size;
+    if (size + num_add <= static_capacity)
+      {return static_capacity;}
+    return 2 * (size + num_add);
+  }
+};
+
+/**
+ * Grows by 1.5, rounded up to whole pages (GROWTH_PAGE_SIZE bytes) once the
+ * buffer is a page or larger: allocators serve such blocks in pages anyway,
+ * so the rounding adds capacity for free. Smaller buffers aren't rounded.
+ */
+struct grow_page_rounded {
+  static size_t capacity (size_t size, size_t num_add, size_t static_capacity,
+                          size_t element_size)
+  {
+    size_t new_capacity = cap_c (size, num_add, static_capacity);
+    size_t bytes = new_capacity * element_size;
+    if (new_capacity == static_capacity || bytes < GROWTH_PAGE_SIZE)
+      {return new_capacity;}
+    bytes = (bytes + GROWTH_PAGE_SIZE - 1) / GROWTH_PAGE_SIZE
+            * GROWTH_PAGE_SIZE;
+    return bytes / element_size;
+  }
+};
+
+/**
+ * Whether moving an element of type T to another address and destroying the
+ * original is the same as copying its bytes, so vl_vector may move elements
+ * with memcpy/memmove. True for trivially copyable types; specialize it as
+ * std::true_type for types that are relocatable but not trivially copyable,
+ * e.g. ones that only own heap memory through a pointer.
+ */
+template <class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+/**
+ * A vector that keeps up to StaticCapacity elements in itself and spills to
+ * dynamic data past that. The dynamic data is allocated by Allocator, which
+ * must be stateless (is_always_equal): vl_vector default constructs one
+ * whenever it allocates or frees, so it stays as small as without one (see
+ * pool_allocator.h).
+ */
+template <class T, size_t StaticCapacity = DEFAULT_CAPACITY,
+          class GrowthPolicy = grow_1_5x, class Allocator = std::allocator<T>>
 class vl_vector {
+  static_assert (std::allocator_traits<Allocator>::is_always_equal::value,
+                 "vl_vector needs a stateless allocator: it doesn't store "
+                 "one, so a stateful one would allocate from a default "
+                 "constructed instance.");
+
   // Help functions.
  private:
   /**
-   * Initializes the dynamic part of the vl_vector.
+   * Points the data at the dynamic part of the vl_vector if its capacity
+   * needs one, or else at the static part. Only allocates it: the elements
+   * are constructed by the caller.
    */
   void create_dynamic_vector ()
   {
-    _dynamic_vector = nullptr;
+    _data = static_data ();
+    if (_capacity > StaticCapacity)
+      {_data = allocate (_capacity);}
+  }
+
+  /**
+   * Creates the data for the capacity and copies [first, last) into it. A
+   * constructor calls it, so if a copy throws the dynamic part is freed:
+   * the destructor won't run.
+   * @param first an iterator to the first element to copy.
+   * @param last an iterator to the after-last element to copy.
+   */
+  template <class InputIterator>
+  void construct_copy (InputIterator first, InputIterator last)
+  {
+    create_dynamic_vector ();
+    try
+      {std::uninitialized_copy (first, last, begin ());}
+    catch (...)
+      {
+        free_dynamic_vector ();
+        throw;
+      }
+  }
+
+  /**
+   * Frees the dynamic part of the vl_vector, if it has one, whose elements
+   * were destroyed. Doesn't update the data and the capacity.
+   */
+  void free_dynamic_vector ()
+  {
     if (_capacity > StaticCapacity)
-      {_dynamic_vector = new T[_capacity] ();}
+      {deallocate (_data, _capacity);}
+  }
+
+  /**
+   * Allocates uninitialized memory for the given number of elements.
+   * @param count the number of elements.
+   * @return a pointer to the allocated memory.
+   */
+  static T *allocate (size_t count)
+  {
+    Allocator allocator;
+    return std::allocator_traits<Allocator>::allocate (allocator, count);
+  }
+
+  /**
+   * Frees memory returned by allocate, whose elements were destroyed.
+   * @param buffer the memory to free.
+   * @param count the number of elements it was allocated for.
+   */
+  static void deallocate (T *buffer, size_t count)
+  {
+    Allocator allocator;
+    std::allocator_traits<Allocator>::deallocate (allocator, buffer, count);
   }
 
   // Functions that are used also for vl_string.
@@ -47,30 +191,247 @@ class vl_vector {
   {
     if (_capacity >= (_size + num_add))
       {return;}
-    size_t new_capacity = cap_c (_size, num_add, StaticCapacity);
-    auto *new_dynamic_vector = new T [new_capacity];
-    std::copy (begin (), end (), new_dynamic_vector);
-    _capacity = new_capacity;
-    delete[] _dynamic_vector;
-    _dynamic_vector = new_dynamic_vector;
+    reallocate (GrowthPolicy::capacity (_size, num_add, StaticCapacity,
+                                        sizeof (T)));
   }
 
   /**
    * Shrinks from the dynamically-allocated part to the static part of the
-   * vl_vector if needed.
-   * @param num_erase the number of elements to erase from the vl_vector.
+   * vl_vector if its elements fit there. Called once the erased elements
+   * were destroyed and the size updated.
    */
-  void check_shrink (size_t num_erase)
+  void check_shrink ()
   {
-    if (_capacity == StaticCapacity || (_size - num_erase) > StaticCapacity)
+    if (_capacity == StaticCapacity || _size > StaticCapacity)
       {return;}
-    std::copy (_dynamic_vector, _dynamic_vector + _size - num_erase,
-               _static_vector);
-    _capacity = StaticCapacity;
-    delete[] _dynamic_vector;
-    _dynamic_vector = nullptr;
+    reallocate (StaticCapacity);
+  }
+
+  /**
+   * Relocates the elements to a dynamic part of the given capacity, or to
+   * the static part if they fit there.
+   * @param new_capacity the new capacity, at least the size.
+   */
+  void reallocate (size_t new_capacity)
+  {
+    T *new_data = static_data ();
+    if (new_capacity > StaticCapacity)
+      {new_data = allocate (new_capacity);}
+    else
+      {new_capacity = StaticCapacity;}
+    try
+      {relocate (begin (), end (), new_data);}
+    catch (...)
+      {
+        if (new_capacity > StaticCapacity)
+          {deallocate (new_data, new_capacity);}
+        throw;
+      }
+    free_dynamic_vector ();
+    _capacity = new_capacity;
+    _data = new_data;
+  }
+
+  typedef std::integral_constant<bool, is_trivially_relocatable<T>::value>
+      relocatable;
+
+  /**
+   * Moves the elements [first, last) into the uninitialized memory at
+   * destination and destroys them there. The ranges may overlap only if T is
+   * relocatable: its elements are moved by memmove.
+   * @param first a pointer to the first element to relocate.
+   * @param last a pointer to the after-last element to relocate.
+   * @param destination a pointer to the memory to relocate to.
+   */
+  static void relocate (T *first, T *last, T *destination)
+  {relocate (first, last, destination, relocatable ());}
+
+  static void relocate (T *first, T *last, T *destination, std::true_type)
+  {
+    std::memmove (static_cast<void *> (destination),
+                  static_cast<const void *> (first),
+                  (size_t) (last - first) * sizeof (T));
+  }
+
+  /**
+   * Copies the elements instead if their move constructor may throw (as
+   * std::move_if_noexcept does), so a throw leaves them intact.
+   */
+  static void relocate (T *first, T *last, T *destination, std::false_type)
+  {
+    typedef typename std::conditional<
+        !std::is_nothrow_move_constructible<T>::value &&
+        std::is_copy_constructible<T>::value,
+        const T *, std::move_iterator<T *>>::type Source;
+    std::uninitialized_copy (Source (first), Source (last), destination);
+    destroy (first, last);
+  }
+
+  /**
+   * Inserts the value at position, after check_expand made room for it.
+   * Relocatable elements after the position move up by memmove.
+   * @param position the position to insert at.
+   * @param value the value to move there.
+   */
+  void shift_in (T *position, T &&value, std::true_type)
+  {
+    relocate (position, end (), position + 1);
+    try
+      {new (position) T (std::move (value));}
+    catch (...)
+      {
+        relocate (position + 1, end () + 1, position); // closes the gap.
+        throw;
+      }
+  }
+
+  void shift_in (T *position, T &&value, std::false_type)
+  {
+    // The last element moves to the uninitialized slot past the end.
+    new (end ()) T (std::move (*(end () - 1)));
+    std::move_backward (position, end () - 1, end ());
+    *position = std::move (value);
+  }
+
+  /**
+   * Inserts the num_add elements [first, last) at position, after
+   * check_expand made room for them.
+   * @param position the position to insert at.
+   * @param first an iterator to the first element to insert.
+   * @param last an iterator to the after-last element to insert.
+   * @param num_add the number of elements to insert.
+   */
+  template <class InputIterator>
+  void shift_in (T *position, InputIterator first, InputIterator last,
+                 size_t num_add, std::true_type)
+  {
+    relocate (position, end (), position + num_add);
+    try
+      {std::uninitialized_copy (first, last, position);}
+    catch (...)
+      {
+        // The copy destroyed the elements it made; closes the gap.
+        relocate (position + num_add, end () + num_add, position);
+        throw;
+      }
+  }
+
+  /**
+   * If a copy throws, the elements constructed past the end are destroyed:
+   * the size is unchanged, but the elements after the position may have
+   * been moved from (as in std::vector).
+   */
+  template <class InputIterator>
+  void shift_in (T *position, InputIterator first, InputIterator last,
+                 size_t num_add, std::false_type)
+  {
+    auto num_after = (size_t) (end () - position);
+    if (num_after > num_add)
+      {
+        // The last num_add elements move past the end, into uninitialized
+        // slots; the rest and the new elements are assigned.
+        std::uninitialized_copy (std::make_move_iterator (end () - num_add),
+                                 std::make_move_iterator (end ()), end ());
+        try
+          {
+            std::move_backward (position, end () - num_add, end ());
+            std::copy (first, last, position);
+          }
+        catch (...)
+          {
+            destroy (end (), end () + num_add);
+            throw;
+          }
+      }
+    else
+      {
+        // The new elements that land past the end and all the elements after
+        // the position are constructed; the other new ones are assigned.
+        InputIterator middle = first;
+        std::advance (middle, num_after);
+        std::uninitialized_copy (middle, last, end ());
+        size_t constructed = num_add - num_after;
+        try
+          {
+            std::uninitialized_copy (std::make_move_iterator (position),
+                                     std::make_move_iterator (end ()),
+                                     position + num_add);
+            constructed = num_add;
+            std::copy (first, middle, position);
+          }
+        catch (...)
+          {
+            destroy (end (), end () + constructed);
+            throw;
+          }
+      }
+  }
+
+  /**
+   * Removes the num_erase elements at position, moving the ones after them
+   * down; the size is updated by the caller.
+   * @param position the position of the first element to remove.
+   * @param num_erase the number of elements to remove.
+   */
+  void shift_out (T *position, size_t num_erase, std::true_type)
+  {
+    destroy (position, position + num_erase);
+    relocate (position + num_erase, end (), position);
   }
 
+  void shift_out (T *position, size_t num_erase, std::false_type)
+  {
+    std::move (position + num_erase, end (), position);
+    destroy (end () - num_erase, end ());
+  }
+
+  /**
+   * Steals the elements of other, leaving it empty: its dynamic data if it
+   * has some, or else its elements, relocated one by one. The vl_vector
+   * holds no elements and no dynamic data before.
+   * @param other another vl_vector to move from.
+   */
+  void take (vl_vector &other)
+  {
+    _size = other._size;
+    _capacity = other._capacity;
+    _data = other._data;
+    if (other._capacity <= StaticCapacity)
+      {
+        _data = static_data ();
+        relocate (other.begin (), other.end (), _data);
+      }
+    other._size = EMPTY_SIZE;
+    other._capacity = StaticCapacity;
+    other._data = other.static_data ();
+  }
+
+  /**
+   * Destroys the elements [first, last).
+   * @param first a pointer to the first element to destroy.
+   * @param last a pointer to the after-last element to destroy.
+   */
+  static void destroy (T *first, T *last)
+  {
+    for (; first != last; first++)
+      {first->~T ();}
+  }
+
+  /**
+   * Returns a pointer to the static data, which holds constructed elements
+   * only at [0, size) while the vl_vector isn't dynamic.
+   * @return a pointer to the beginning of the static storage.
+   */
+  T *static_data ()
+  {return reinterpret_cast<T *> (_static_vector);}
+
+  /**
+   * A constant version of the static_data function.
+   * @return a constant pointer to the beginning of the static storage.
+   */
+  const T *static_data () const
+  {return reinterpret_cast<const T *> (_static_vector);}
+
  public:
   /**
    * Typedefs of iterator and const_iterator (pointer iterators).
@@ -88,18 +449,24 @@ class vl_vector {
    * Default Constructor. Initializes an empty vl_vector.
    */
   vl_vector () : _size (EMPTY_SIZE), _capacity (StaticCapacity),
-  _dynamic_vector (nullptr) {}
+  _data (static_data ()) {}
 
   /**
    * Copy Constructor. Initializes a vl_vector from another vl_vector.
    * @param other another vl_vector to initialize from.
    */
-  vl_vector (const vl_vector<T, StaticCapacity> &other) :
+  vl_vector (const vl_vector &other) :
   _size (other._size), _capacity (other._capacity)
-  {
-    create_dynamic_vector ();
-    std::copy (other.begin (), other.end (), begin ());
-  }
+  {construct_copy (other.begin (), other.end ());}
+
+  /**
+   * Move Constructor. Takes the dynamic data of other, or moves its elements
+   * if they are in its static data; other is left empty.
+   * @param other another vl_vector to move from.
+   */
+  vl_vector (vl_vector &&other) noexcept (
+      std::is_nothrow_move_constructible<T>::value)
+  {take (other);}
 
   /**
    * Sequence based Constructor.
@@ -112,9 +479,9 @@ class vl_vector {
   vl_vector (InputIterator first, InputIterator last)
   {
     _size = (size_t) std::distance (first, last);
-    _capacity = cap_c (EMPTY_SIZE, _size, StaticCapacity);
-    create_dynamic_vector ();
-    std::copy (first, last, begin ());
+    _capacity = GrowthPolicy::capacity (EMPTY_SIZE, _size, StaticCapacity,
+                                        sizeof (T));
+    construct_copy (first, last);
   }
 
   /**
@@ -126,28 +493,33 @@ class vl_vector {
   vl_vector (size_t count, const T v)
   {
     _size = count;
-    _capacity = cap_c (EMPTY_SIZE, _size, StaticCapacity);
+    _capacity = GrowthPolicy::capacity (EMPTY_SIZE, _size, StaticCapacity,
+                                        sizeof (T));
     create_dynamic_vector ();
-    std::fill (begin (), end (), v);
+    try
+      {std::uninitialized_fill (begin (), end (), v);}
+    catch (...)
+      {
+        free_dynamic_vector ();
+        throw;
+      }
   }
 
   /**
-   * Destructor.
+   * Destructor. Not virtual, like the rest of the functions: a vl_vector
+   * (or a vl_string) must not be deleted through a pointer to a base.
    */
-  virtual ~vl_vector ()
+  ~vl_vector ()
   {
-    if (_capacity > StaticCapacity)
-      {
-        delete[] _dynamic_vector;
-        _dynamic_vector = nullptr;
-      }
+    destroy (begin (), end ());
+    free_dynamic_vector ();
   }
 
   /**
    * Returns the current number of elements in the vl_vector.
    * @return the value of the size field of the vl_vector.
    */
-  virtual size_t size () const
+  size_t size () const
   {return _size;}
 
   /**
@@ -158,13 +530,35 @@ class vl_vector {
   size_t capacity () const
   {return _capacity;}
 
+  /**
+   * Grows the capacity to at least the given number of elements, so adding
+   * elements up to it doesn't reallocate. Erasing down to the static
+   * capacity still moves the elements back to the static data.
+   * @param new_capacity the number of elements to make room for.
+   */
+  void reserve (size_t new_capacity)
+  {
+    if (new_capacity > _capacity)
+      {reallocate (new_capacity);}
+  }
+
+  /**
+   * Shrinks the dynamic data to the size of the vl_vector, or moves the
+   * elements to the static data if they fit there.
+   */
+  void shrink_to_fit ()
+  {
+    if (_capacity > StaticCapacity && _capacity > _size)
+      {reallocate (_size);}
+  }
+
   /**
    * Checks if the vl_vector is empty.
    * @return true if the value of the field size of the vl_vector is equal
    * to zero, false otherwise.
    */
   bool empty () const
-  {return size () == EMPTY_SIZE;}
+  {return _size == EMPTY_SIZE;}
 
   /**
    * Returns the element at the given index in the vl_vector. If the given
@@ -196,11 +590,37 @@ class vl_vector {
    * Adds the given value to the end of the vl_vector.
    * @param value the value of the type T to add at the end of the vl_vector.
    */
-  virtual void push_back (const T value)
+  void push_back (const T &value)
+  {emplace_back (value);}
+
+  /**
+   * Moves the given value to the end of the vl_vector.
+   * @param value the value of the type T to move to the end of the vl_vector.
+   */
+  void push_back (T &&value)
+  {emplace_back (std::move (value));}
+
+  /**
+   * Constructs an element from the given arguments at the end of the
+   * vl_vector. The arguments may refer to elements of the vl_vector.
+   * @tparam Args the types of the arguments of T's constructor.
+   * @param args the arguments of T's constructor.
+   * @return a reference to the new element.
+   */
+  template <class... Args>
+  T &emplace_back (Args &&... args)
   {
-    check_expand (1);
-    *(end ()) = value;
+    if (_size < _capacity)
+      {new (end ()) T (std::forward<Args> (args)...);}
+    else
+      {
+        // Built before the elements are relocated, which may be its source.
+        T value (std::forward<Args> (args)...);
+        check_expand (1);
+        new (end ()) T (std::move (value));
+      }
     _size++;
+    return *(end () - 1);
   }
 
   /**
@@ -209,14 +629,39 @@ class vl_vector {
    * @param value the value of the type T to insert before the position.
    * @return an iterator that points on the inserted value.
    */
-  iterator insert (const_iterator position, const T value)
+  iterator insert (const_iterator position, const T &value)
+  {return emplace (position, value);}
+
+  /**
+   * Moves the given value before the given position (on the left).
+   * @param position the given position to insert before.
+   * @param value the value of the type T to move before the position.
+   * @return an iterator that points on the inserted value.
+   */
+  iterator insert (const_iterator position, T &&value)
+  {return emplace (position, std::move (value));}
+
+  /**
+   * Constructs an element from the given arguments before the given position
+   * (on the left). The arguments may refer to elements of the vl_vector.
+   * @tparam Args the types of the arguments of T's constructor.
+   * @param position the given position to insert before.
+   * @param args the arguments of T's constructor.
+   * @return an iterator that points on the inserted value.
+   */
+  template <class... Args>
+  iterator emplace (const_iterator position, Args &&... args)
   {
     auto saved_distance = (size_t) std::distance (cbegin (), position);
+    if (saved_distance == _size)
+      {
+        emplace_back (std::forward<Args> (args)...);
+        return end () - 1;
+      }
+    T value (std::forward<Args> (args)...);
     check_expand (1);
     iterator updated_position = (begin () + saved_distance);
-    for (auto it = (end () - 1); it != (updated_position - 1); it--)
-      {*(it + 1) = *it;}
-    *updated_position = value;
+    shift_in (updated_position, std::move (value), relocatable ());
     _size++;
     return updated_position;
   }
@@ -238,9 +683,9 @@ class vl_vector {
     auto saved_distance = (size_t) std::distance (cbegin (), position);
     check_expand (num_add);
     iterator updated_position = (begin () + saved_distance);
-    for (auto it = (end () - 1); it != (updated_position - 1); it--)
-      {*(it + num_add) = *it;}
-    std::copy (first, last, updated_position);
+    if (num_add == EMPTY_SIZE)
+      {return updated_position;} // nothing to move onto itself.
+    shift_in (updated_position, first, last, num_add, relocatable ());
     _size+=num_add;
     return updated_position;
   }
@@ -249,12 +694,13 @@ class vl_vector {
    * Erases one element from the back of the vl_vector. If the vl-vector is
    * empty, then the function terminates.
    */
-  virtual void pop_back ()
+  void pop_back ()
   {
-    if (empty ())
+    if (_size == EMPTY_SIZE)
       {return;}
-    check_shrink (1);
+    (end () - 1)->~T ();
     _size--;
+    check_shrink ();
   }
 
   /**
@@ -265,12 +711,7 @@ class vl_vector {
    */
   iterator erase (const_iterator position)
   {
-    auto saved_distance = (size_t) std::distance (cbegin (), position);
-    for (auto it = (begin () + saved_distance); it != (end () - 1); it++)
-      {*it = *(it + 1);}
-    check_shrink (1);
-    _size--;
-    return (begin () + saved_distance);
+    return erase (position, position + 1);
   }
 
   /**
@@ -284,23 +725,24 @@ class vl_vector {
   {
     auto num_erase = (size_t) std::distance (first, last);
     auto saved_distance = (size_t) std::distance (cbegin (), first);
-    for (auto it = (begin () + saved_distance); it != (end () - num_erase);
-    it++)
-      {*it = *(it + num_erase);}
-    check_shrink (num_erase);
+    if (num_erase == EMPTY_SIZE)
+      {return (begin () + saved_distance);} // nothing to move onto itself.
+    shift_out (begin () + saved_distance, num_erase, relocatable ());
     _size-=num_erase;
+    check_shrink ();
     return (begin () + saved_distance);
   }
 
   /**
    * Erases all the data from the vl_vector.
    */
-  virtual void clear ()
+  void clear ()
   {
+    destroy (begin (), end ());
+    free_dynamic_vector ();
     _size = EMPTY_SIZE;
     _capacity = StaticCapacity;
-    delete[] _dynamic_vector;
-    _dynamic_vector = nullptr;
+    _data = static_data ();
   }
 
   /**
@@ -310,11 +752,7 @@ class vl_vector {
    * on the current state of the vl_vector.
    */
   T* data ()
-  {
-    if (_capacity > StaticCapacity)
-      {return _dynamic_vector;}
-    return _static_vector;
-  }
+  {return _data;}
 
   /**
    * A constant version of the data function.
@@ -322,11 +760,7 @@ class vl_vector {
    * depending on the current state of the vl_vector.
    */
   const T* data () const
-  {
-    if (_capacity > StaticCapacity)
-      {return _dynamic_vector;}
-    return _static_vector;
-  }
+  {return _data;}
 
   /**
    * Checks if the given value is in the vl_vector.
@@ -414,20 +848,47 @@ class vl_vector {
   const_reverse_iterator crend () const {return const_reverse_iterator (
         cbegin ());}
 
- /**
- * Assigns to the vl_vector.
- * @param other another vl_vector to assign from.
- * @return a reference to the current vl_vector that was changed.
- */
-  vl_vector &operator= (const vl_vector<T, StaticCapacity> &other)
+  /**
+   * Assigns to the vl_vector, reusing its dynamic data if other has the same
+   * capacity. If copying an element throws, the vl_vector is left empty.
+   * @param other another vl_vector to assign from.
+   * @return a reference to the current vl_vector that was changed.
+   */
+  vl_vector &operator= (const vl_vector &other)
   {
     if (this != &other)
       {
+        destroy (begin (), end ());
+        _size = EMPTY_SIZE;
+        if (_capacity != other._capacity)
+          {
+            // Static until the allocation succeeds, so a throw leaves a
+            // valid empty vl_vector.
+            free_dynamic_vector ();
+            _capacity = StaticCapacity;
+            _data = static_data ();
+            reserve (other._capacity);
+          }
+        std::uninitialized_copy (other.begin (), other.end (), begin ());
         _size = other._size;
-        _capacity = other._capacity;
-        delete[] _dynamic_vector;
-        create_dynamic_vector ();
-        std::copy (other.begin (), other.end (), begin ());
+      }
+    return *this;
+  }
+
+  /**
+   * Move-assigns to the vl_vector: frees its elements, then takes the
+   * dynamic data or the elements of other, leaving it empty.
+   * @param other another vl_vector to move from.
+   * @return a reference to the current vl_vector that was changed.
+   */
+  vl_vector &operator= (vl_vector &&other) noexcept (
+      std::is_nothrow_move_constructible<T>::value)
+  {
+    if (this != &other)
+      {
+        destroy (begin (), end ());
+        free_dynamic_vector ();
+        take (other);
       }
     return *this;
   }
@@ -457,8 +918,7 @@ class vl_vector {
    * @return true if they are equal (their size is equal, all the values and
    * the order of the values), false otherwise.
    */
-  friend bool operator == (const vl_vector<T, StaticCapacity> &lhs, const
-  vl_vector<T, StaticCapacity> &rhs)
+  friend bool operator == (const vl_vector &lhs, const vl_vector &rhs)
   {
     if (lhs._size != rhs._size)
       {return false;}
@@ -476,15 +936,19 @@ class vl_vector {
    * @param rhs the vl_vector on the right side of the comparison.
    * @return true if they are unequal, false otherwise.
    */
-  friend bool operator != (const vl_vector<T, StaticCapacity> &lhs, const
-  vl_vector<T, StaticCapacity> &rhs)
+  friend bool operator != (const vl_vector &lhs, const vl_vector &rhs)
   {return !(lhs == rhs);}
 
  protected:
   size_t _size; // real number of elements in the vector.
   size_t _capacity; // maximal number of elements in the vector.
-  T _static_vector[StaticCapacity]; // static data of the vector.
-  T *_dynamic_vector; // dynamic data of the vector.
+  // the static data or the dynamic data, whichever holds the elements, so
+  // that accessing them doesn't branch on the capacity.
+  T *_data;
+  // static data of the vector, uninitialized: elements are constructed in
+  // it only as they are added.
+  typename std::aligned_storage<sizeof (T), alignof (T)>::type
+      _static_vector[StaticCapacity];
 };
 
 #endif //_VL_VECTOR_H_